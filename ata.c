@@ -0,0 +1,423 @@
+#include "ata.h"
+#include "io.h"
+#include "irq.h"
+#include "kernel.h"
+#include "softirq.h"
+#include "tsc.h"
+
+#define ATA_REG_DATA 0
+#define ATA_REG_ERROR 1
+#define ATA_REG_SECTOR_COUNT 2
+#define ATA_REG_LBA_LOW 3
+#define ATA_REG_LBA_MID 4
+#define ATA_REG_LBA_HIGH 5
+#define ATA_REG_DEVICE 6
+#define ATA_REG_COMMAND 7
+#define ATA_REG_STATUS 7
+
+#define ATA_STATUS_BUSY 0x80
+#define ATA_STATUS_DF 0x20
+#define ATA_STATUS_DRQ 0x08
+#define ATA_STATUS_ERR 0x01
+
+#define ATA_CTRL_NIEN 0x02 // прерывания выключены (на время опроса дисков)
+
+#define ATA_CMD_READ 0x20
+#define ATA_CMD_WRITE 0x30
+#define ATA_CMD_FLUSH 0xE7
+#define ATA_CMD_IDENTIFY 0xEC
+
+#define ATA_MAX_COMMAND 255   // секторов в одной команде
+#define ATA_TIMEOUT 1000000   // опросов статуса без прогресса
+
+struct ata_channel {
+  uint16_t base;
+  uint16_t ctrl;
+  uint8_t irq;
+  struct blk_request *active; // на канале одна команда одновременно
+  struct ata_drive *active_drive;
+};
+
+struct ata_drive {
+  struct block_device dev;
+  struct ata_channel *channel;
+  uint8_t slave;
+  char model[41];
+};
+
+static struct ata_channel channels[ATA_CHANNELS] = {
+    {0x1F0, 0x3F6, IRQ_ATA_PRIMARY, NULL, NULL},
+    {0x170, 0x376, IRQ_ATA_SECONDARY, NULL, NULL},
+};
+static struct ata_drive drives[ATA_CHANNELS * 2];
+
+struct block_device *boot_disk = NULL;
+
+static inline void ata_insw(uint16_t port, void *buf, uint32_t words) {
+  __asm__ volatile("rep insw"
+                   : "+D"(buf), "+c"(words)
+                   : "d"(port)
+                   : "memory");
+}
+
+static inline void ata_outsw(uint16_t port, const void *buf, uint32_t words) {
+  __asm__ volatile("rep outsw" : "+S"(buf), "+c"(words) : "d"(port));
+}
+
+// ~400ns после выбора устройства: четыре чтения альтернативного статуса
+static void ata_delay(struct ata_channel *ch) {
+  for (int i = 0; i < 4; i++) {
+    port_inb(ch->ctrl);
+  }
+}
+
+static int ata_wait_idle(struct ata_channel *ch) {
+  for (int timeout = ATA_TIMEOUT; timeout > 0; timeout--) {
+    if ((port_inb(ch->base + ATA_REG_STATUS) & ATA_STATUS_BUSY) == 0) {
+      return 0;
+    }
+  }
+  return -1;
+}
+
+// Выбор устройства и команда IDENTIFY; -1 - устройства нет
+static int ata_identify_start(struct ata_drive *d) {
+  struct ata_channel *ch = d->channel;
+
+  port_outb(0xA0 | (d->slave << 4), ch->base + ATA_REG_DEVICE);
+  ata_delay(ch);
+  port_outb(0, ch->base + ATA_REG_SECTOR_COUNT);
+  port_outb(0, ch->base + ATA_REG_LBA_LOW);
+  port_outb(0, ch->base + ATA_REG_LBA_MID);
+  port_outb(0, ch->base + ATA_REG_LBA_HIGH);
+  port_outb(ATA_CMD_IDENTIFY, ch->base + ATA_REG_COMMAND);
+
+  uint8_t status = port_inb(ch->base + ATA_REG_STATUS);
+  if (status == 0x00 || status == 0xFF) {
+    return -1; // нет устройства или "плавающая" шина
+  }
+  return 0;
+}
+
+// Ожидание ответа на IDENTIFY: пока диск занят, второй канал работает
+static int ata_identify_finish(struct ata_drive *d) {
+  struct ata_channel *ch = d->channel;
+  uint16_t id[256];
+  uint8_t status;
+
+  if (ata_wait_idle(ch) != 0) {
+    return -1;
+  }
+  // ATAPI и SATA отвечают сигнатурой в LBA mid/high
+  if (port_inb(ch->base + ATA_REG_LBA_MID) ||
+      port_inb(ch->base + ATA_REG_LBA_HIGH)) {
+    return -1;
+  }
+  for (int timeout = ATA_TIMEOUT;; timeout--) {
+    status = port_inb(ch->base + ATA_REG_STATUS);
+    if ((status & ATA_STATUS_ERR) || timeout == 0) {
+      return -1;
+    }
+    if (status & ATA_STATUS_DRQ) {
+      break;
+    }
+  }
+  ata_insw(ch->base + ATA_REG_DATA, id, 256);
+
+  d->dev.sectors = id[60] | ((uint32_t)id[61] << 16);
+  d->dev.sector_size = SECTOR_SIZE;
+  if (d->dev.sectors == 0) {
+    return -1; // без LBA не работаем
+  }
+  // Модель: слова 27-46, байты в словах переставлены
+  for (int i = 0; i < 20; i++) {
+    d->model[i * 2] = id[27 + i] >> 8;
+    d->model[i * 2 + 1] = id[27 + i] & 0xFF;
+  }
+  d->model[40] = '\0';
+  for (int i = 39; i >= 0 && d->model[i] == ' '; i--) {
+    d->model[i] = '\0';
+  }
+  return 0;
+}
+
+// Следующая команда запроса (запрос длиннее ATA_MAX_COMMAND идёт частями)
+static int ata_issue(struct ata_drive *d, struct blk_request *rq) {
+  struct ata_channel *ch = d->channel;
+  uint32_t lba = rq->lba + rq->done;
+  uint32_t n = rq->count - rq->done;
+  if (n > ATA_MAX_COMMAND) {
+    n = ATA_MAX_COMMAND;
+  }
+  if (ata_wait_idle(ch) != 0) {
+    return BLK_EIO;
+  }
+  port_outb(0xE0 | (d->slave << 4) | ((lba >> 24) & 0x0F),
+            ch->base + ATA_REG_DEVICE);
+  port_outb(n, ch->base + ATA_REG_SECTOR_COUNT);
+  port_outb(lba & 0xFF, ch->base + ATA_REG_LBA_LOW);
+  port_outb((lba >> 8) & 0xFF, ch->base + ATA_REG_LBA_MID);
+  port_outb((lba >> 16) & 0xFF, ch->base + ATA_REG_LBA_HIGH);
+  port_outb(rq->write ? ATA_CMD_WRITE : ATA_CMD_READ,
+            ch->base + ATA_REG_COMMAND);
+  rq->cmd_left = n;
+  rq->spins = 0;
+  return 0;
+}
+
+// Шаг запроса делают и опрос, и прерывание диска, поэтому выдача
+// команды и шаг идут с выключенными прерываниями
+static int ata_submit(struct block_device *dev, struct blk_request *rq) {
+  struct ata_drive *d = dev->priv;
+  uint32_t flags = irq_save();
+  if (d->channel->active) {
+    irq_restore(flags);
+    return BLK_EBUSY;
+  }
+  rq->done = 0;
+  rq->status = BLK_PENDING;
+  int rc = ata_issue(d, rq);
+  if (rc == 0) {
+    d->channel->active = rq;
+    d->channel->active_drive = d;
+  }
+  irq_restore(flags);
+  return rc;
+}
+
+static int ata_complete(struct ata_drive *d, struct blk_request *rq,
+                        int status) {
+  rq->status = status;
+  d->channel->active = NULL;
+  d->channel->active_drive = NULL;
+  return 1;
+}
+
+// За один шаг передаётся не больше сектора, чтобы опрос нескольких
+// каналов по кругу не ждал, пока один из них закончит весь запрос
+static int ata_step(struct ata_drive *d, struct blk_request *rq) {
+  struct ata_channel *ch = d->channel;
+  uint8_t status = port_inb(ch->base + ATA_REG_STATUS);
+
+  if (status & ATA_STATUS_BUSY) {
+    if (++rq->spins > ATA_TIMEOUT) {
+      return ata_complete(d, rq, BLK_EIO);
+    }
+    return 0;
+  }
+  if (status & (ATA_STATUS_ERR | ATA_STATUS_DF)) {
+    return ata_complete(d, rq, BLK_EIO);
+  }
+  if (rq->cmd_left > 0) {
+    if (!(status & ATA_STATUS_DRQ)) {
+      if (++rq->spins > ATA_TIMEOUT) {
+        return ata_complete(d, rq, BLK_EIO);
+      }
+      return 0;
+    }
+    uint8_t *buf = rq->buf + rq->done * SECTOR_SIZE;
+    if (rq->write) {
+      ata_outsw(ch->base + ATA_REG_DATA, buf, SECTOR_SIZE / 2);
+    } else {
+      ata_insw(ch->base + ATA_REG_DATA, buf, SECTOR_SIZE / 2);
+    }
+    rq->done++;
+    rq->cmd_left--;
+    rq->spins = 0;
+    // Запись заканчивается, когда диск снимет BUSY после последнего сектора
+    if (rq->cmd_left > 0 || rq->write) {
+      return 0;
+    }
+  }
+  if (rq->done < rq->count) {
+    if (ata_issue(d, rq) != 0) {
+      return ata_complete(d, rq, BLK_EIO);
+    }
+    return 0;
+  }
+  return ata_complete(d, rq, 0);
+}
+
+// Запрос мог завершиться в обработчике прерывания между вызовами
+static int ata_poll(struct block_device *dev, struct blk_request *rq) {
+  uint32_t flags = irq_save();
+  int finished = rq->status != BLK_PENDING || ata_step(dev->priv, rq);
+  irq_restore(flags);
+  return finished;
+}
+
+static int ata_sync(struct block_device *dev, uint32_t lba, void *buf,
+                    uint32_t count, int write) {
+  struct blk_request rq;
+  memset(&rq, 0, sizeof(rq));
+  rq.lba = lba;
+  rq.buf = buf;
+  rq.count = count;
+  rq.write = write;
+  int rc = ata_submit(dev, &rq);
+  if (rc != 0) {
+    return rc;
+  }
+  while (!ata_poll(dev, &rq)) {
+  }
+  return rq.status;
+}
+
+static int ata_read_op(struct block_device *dev, uint32_t lba, void *buf,
+                       uint32_t count) {
+  return ata_sync(dev, lba, buf, count, 0);
+}
+
+static int ata_write_op(struct block_device *dev, uint32_t lba,
+                        const void *buf, uint32_t count) {
+  return ata_sync(dev, lba, (void *)buf, count, 1);
+}
+
+static int ata_flush(struct block_device *dev) {
+  struct ata_drive *d = dev->priv;
+  struct ata_channel *ch = d->channel;
+
+  if (ch->active || ata_wait_idle(ch) != 0) {
+    return BLK_EBUSY;
+  }
+  port_outb(0xE0 | (d->slave << 4), ch->base + ATA_REG_DEVICE);
+  ata_delay(ch);
+  port_outb(ATA_CMD_FLUSH, ch->base + ATA_REG_COMMAND);
+  if (ata_wait_idle(ch) != 0 ||
+      (port_inb(ch->base + ATA_REG_STATUS) & ATA_STATUS_ERR)) {
+    return BLK_EIO;
+  }
+  return 0;
+}
+
+static const struct block_ops ata_ops = {
+    "ata", ata_read_op, ata_write_op, ata_flush, ata_submit, ata_poll,
+};
+
+// Чтение статуса снимает запрос прерывания; остальное - отложенно
+static void ata_irq(int irq) {
+  int c = irq == IRQ_ATA_PRIMARY ? 0 : 1;
+  uint8_t status = port_inb(channels[c].base + ATA_REG_STATUS);
+  work_queue(WORK_DISK, c | (status << 8));
+}
+
+// Прерывание значит, что диск готов к следующему сектору или закончил
+// команду: шаг делается здесь, и ata_poll увидит готовый запрос.
+// Ошибки без запроса на канале только сообщаются
+static void ata_irq_work(uint32_t arg) {
+  struct ata_channel *ch = &channels[arg & 0xFF];
+  uint8_t status = arg >> 8;
+
+  uint32_t flags = irq_save();
+  if (ch->active) {
+    ata_step(ch->active_drive, ch->active);
+  } else if (status & (ATA_STATUS_ERR | ATA_STATUS_DF)) {
+    print_string("ATA: channel ");
+    print_uint(arg & 0xFF);
+    print_string(" error, status ");
+    print_hex(status);
+    print_char('\n');
+  }
+  irq_restore(flags);
+}
+
+// Каналы независимы: с parallel IDENTIFY уходит на оба канала сразу и
+// ожидание ответов перекрывается; иначе диски опрашиваются по одному.
+// Ответы IDENTIFY пишутся в set (ATA_CHANNELS * 2 дисков)
+static void ata_probe(struct ata_drive *set, int parallel, int *found) {
+  for (int slave = 0; slave < 2; slave++) {
+    int started[ATA_CHANNELS];
+    for (int c = 0; c < ATA_CHANNELS; c++) {
+      struct ata_drive *d = &set[c * 2 + slave];
+      d->channel = &channels[c];
+      d->slave = slave;
+      started[c] = ata_identify_start(d) == 0;
+      if (!parallel) {
+        found[c * 2 + slave] = started[c] && ata_identify_finish(d) == 0;
+      }
+    }
+    for (int c = 0; parallel && c < ATA_CHANNELS; c++) {
+      found[c * 2 + slave] =
+          started[c] && ata_identify_finish(&set[c * 2 + slave]) == 0;
+    }
+  }
+}
+
+// Повтор для bootlog -p: ответы - во временные структуры, чтобы не
+// затереть зарегистрированные диски, и с nIEN, чтобы IDENTIFY (и его
+// отказ на ATAPI) не доходил до ata_irq
+uint64_t ata_probe_cycles(int parallel) {
+  struct ata_drive scratch[ATA_CHANNELS * 2];
+  int found[ATA_CHANNELS * 2];
+
+  for (int c = 0; c < ATA_CHANNELS; c++) {
+    port_outb(ATA_CTRL_NIEN, channels[c].ctrl);
+  }
+  uint64_t start = rdtsc();
+  ata_probe(scratch, parallel, found);
+  uint64_t cycles = rdtsc() - start;
+  for (int c = 0; c < ATA_CHANNELS; c++) {
+    if (drives[c * 2].dev.ops || drives[c * 2 + 1].dev.ops) {
+      port_outb(0, channels[c].ctrl);
+    }
+  }
+  return cycles;
+}
+
+int ata_init(void) {
+  int found[ATA_CHANNELS * 2];
+
+  for (int c = 0; c < ATA_CHANNELS; c++) {
+    port_outb(ATA_CTRL_NIEN, channels[c].ctrl);
+  }
+  ata_probe(drives, 1, found);
+  for (int c = 0; c < ATA_CHANNELS; c++) {
+    for (int slave = 0; slave < 2; slave++) {
+      struct ata_drive *d = &drives[c * 2 + slave];
+      if (!found[c * 2 + slave]) {
+        continue;
+      }
+      d->dev.name[0] = 'h';
+      d->dev.name[1] = 'd';
+      d->dev.name[2] = 'a' + c * 2 + slave;
+      d->dev.name[3] = '\0';
+      d->dev.ops = &ata_ops;
+      d->dev.priv = d;
+      blk_register(&d->dev);
+
+      print_string(d->dev.name);
+      print_string(": ");
+      print_string(d->model);
+      print_string(", ");
+      print_uint(d->dev.sectors / 2048);
+      print_string(" MB\n");
+      if (!boot_disk) {
+        boot_disk = &d->dev;
+      }
+    }
+  }
+  if (!boot_disk) {
+    print_string("ATA: device not found\n");
+    return -1;
+  }
+  softirq_register(WORK_DISK, "disk", ata_irq_work);
+  for (int c = 0; c < ATA_CHANNELS; c++) {
+    if (drives[c * 2].dev.ops || drives[c * 2 + 1].dev.ops) {
+      irq_install(channels[c].irq, ata_irq);
+      port_outb(0, channels[c].ctrl); // снять nIEN
+    }
+  }
+  return 0;
+}
+
+void ata_read(uint32_t lba, uint8_t *buffer, uint32_t sector_count) {
+  if (!boot_disk || blk_read(boot_disk, lba, buffer, sector_count) != 0) {
+    print_string("ATA: read error at lba ");
+    print_uint(lba);
+    print_char('\n');
+  }
+}
+
+void ata_read_blocks(uint32_t lba, uint8_t *buffer, uint32_t count) {
+  ata_read(lba, buffer, count);
+}
@@ -0,0 +1,27 @@
+#ifndef KERNEL_ATA_H
+#define KERNEL_ATA_H
+
+// Диски ATA (PIO, LBA28) на первичном (0x1F0) и вторичном (0x170) каналах.
+// Найденные диски регистрируются как hda/hdb (первичный master/slave) и
+// hdc/hdd (вторичный).
+
+#include "blkdev.h"
+#include "types.h"
+
+#define ATA_CHANNELS 2
+
+// Первый найденный диск; на нём файловая система
+extern struct block_device *boot_disk;
+
+// Опрос обоих каналов; 0 - есть хотя бы один диск
+int ata_init(void);
+
+// Повторный опрос без регистрации дисков, тактов: по одному диску
+// (parallel = 0) или оба канала сразу
+uint64_t ata_probe_cycles(int parallel);
+
+// Чтение с boot_disk
+void ata_read(uint32_t lba, uint8_t *buffer, uint32_t sector_count);
+void ata_read_blocks(uint32_t lba, uint8_t *buffer, uint32_t count);
+
+#endif
@@ -0,0 +1,195 @@
+#include "blkdev.h"
+#include "kernel.h"
+#include "raid0.h"
+#include "tsc.h"
+
+#define BENCH_REQUEST 128 // секторов на запрос (64 KB)
+#define BENCH_DEFAULT_MB 4
+#define RAID_DEFAULT_CHUNK_KB 8
+
+struct block_device *blk_devices[BLK_MAX_DEVICES];
+int blk_count = 0;
+
+int blk_register(struct block_device *dev) {
+  if (blk_count == BLK_MAX_DEVICES) {
+    return -1;
+  }
+  blk_devices[blk_count++] = dev;
+  return 0;
+}
+
+struct block_device *blk_find(const char *name) {
+  for (int i = 0; i < blk_count; i++) {
+    if (!strcmp(blk_devices[i]->name, name)) {
+      return blk_devices[i];
+    }
+  }
+  return NULL;
+}
+
+static int blk_range_ok(struct block_device *dev, uint32_t lba,
+                        uint32_t count) {
+  return lba < dev->sectors && count <= dev->sectors - lba;
+}
+
+int blk_read(struct block_device *dev, uint32_t lba, void *buf,
+             uint32_t count) {
+  if (!blk_range_ok(dev, lba, count)) {
+    return BLK_EIO;
+  }
+  return dev->ops->read(dev, lba, buf, count);
+}
+
+int blk_write(struct block_device *dev, uint32_t lba, const void *buf,
+              uint32_t count) {
+  if (!blk_range_ok(dev, lba, count)) {
+    return BLK_EIO;
+  }
+  return dev->ops->write(dev, lba, buf, count);
+}
+
+int blk_flush(struct block_device *dev) {
+  return dev->ops->flush ? dev->ops->flush(dev) : 0;
+}
+
+int blk_submit(struct block_device *dev, struct blk_request *rq) {
+  if (!blk_range_ok(dev, rq->lba, rq->count)) {
+    return BLK_EIO;
+  }
+  if (dev->ops->submit) {
+    return dev->ops->submit(dev, rq);
+  }
+  rq->status = rq->write ? dev->ops->write(dev, rq->lba, rq->buf, rq->count)
+                         : dev->ops->read(dev, rq->lba, rq->buf, rq->count);
+  rq->done = rq->status == 0 ? rq->count : 0;
+  return 0;
+}
+
+int blk_poll(struct block_device *dev, struct blk_request *rq) {
+  return dev->ops->poll ? dev->ops->poll(dev, rq) : 1;
+}
+
+static uint32_t parse_uint(const char *s) {
+  uint32_t v = 0;
+  while (*s >= '0' && *s <= '9') {
+    v = v * 10 + (*s++ - '0');
+  }
+  return v;
+}
+
+void cmd_lsblk(int argc, char **argv) {
+  for (int i = 0; i < blk_count; i++) {
+    struct block_device *dev = blk_devices[i];
+    print_string(dev->name);
+    print_string(" ");
+    print_string((char *)dev->ops->name);
+    print_string(" ");
+    print_uint(dev->sectors);
+    print_string(" sectors x ");
+    print_uint(dev->sector_size);
+    print_string(" (");
+    print_uint(dev->sectors / 2048);
+    print_string(" MB)\n");
+  }
+}
+
+// raid [-c chunk_kb] <dev> <dev> ...
+void cmd_raid(int argc, char **argv) {
+  struct block_device *members[RAID0_MAX_MEMBERS];
+  uint32_t chunk_kb = RAID_DEFAULT_CHUNK_KB;
+  int count = 0;
+  int arg = 1;
+
+  if (arg + 1 < argc && !strcmp(argv[arg], "-c")) {
+    chunk_kb = parse_uint(argv[arg + 1]);
+    arg += 2;
+  }
+  if (argc - arg < 2 || argc - arg > RAID0_MAX_MEMBERS || chunk_kb == 0) {
+    print_string("usage: raid [-c chunk_kb] <dev> <dev> ... (2-4 disks)\n");
+    return;
+  }
+  for (; arg < argc; arg++) {
+    members[count] = blk_find(argv[arg]);
+    if (!members[count]) {
+      print_string("error: no such device ");
+      print_string(argv[arg]);
+      print_char('\n');
+      return;
+    }
+    count++;
+  }
+  struct block_device *dev = raid0_create(members, count, chunk_kb * 2);
+  if (!dev) {
+    print_string("error: cannot create array\n");
+    return;
+  }
+  print_string(dev->name);
+  print_string(": raid0, ");
+  print_uint(count);
+  print_string(" disks, chunk ");
+  print_uint(chunk_kb);
+  print_string(" KB, ");
+  print_uint(dev->sectors / 2048);
+  print_string(" MB\n");
+}
+
+static void bench_device(struct block_device *dev, uint32_t mb) {
+  static uint8_t buffer[BENCH_REQUEST * SECTOR_SIZE];
+  uint32_t total = mb * 2048;
+  if (total > dev->sectors) {
+    total = dev->sectors;
+  }
+
+  uint64_t start = rdtsc();
+  uint32_t lba = 0;
+  while (lba < total) {
+    uint32_t n = total - lba;
+    if (n > BENCH_REQUEST) {
+      n = BENCH_REQUEST;
+    }
+    if (blk_read(dev, lba, buffer, n) != 0) {
+      print_string(dev->name);
+      print_string(": read error\n");
+      return;
+    }
+    lba += n;
+  }
+  uint32_t us = tsc_to_us(rdtsc() - start);
+
+  print_string(dev->name);
+  print_string(": ");
+  print_uint(total / 2);
+  print_string(" KB in ");
+  print_uint(us);
+  print_string(" us, ");
+  print_throughput((uint64_t)total * SECTOR_SIZE, us);
+  print_char('\n');
+}
+
+// blkbench [-m mb] [dev ...]: последовательное чтение; без имён - все
+// устройства подряд, чтобы сравнить массив с одиночным диском
+void cmd_blkbench(int argc, char **argv) {
+  uint32_t mb = BENCH_DEFAULT_MB;
+  int arg = 1;
+
+  if (arg + 1 < argc && !strcmp(argv[arg], "-m")) {
+    mb = parse_uint(argv[arg + 1]);
+    arg += 2;
+  }
+  if (arg == argc) {
+    for (int i = 0; i < blk_count; i++) {
+      bench_device(blk_devices[i], mb);
+    }
+    return;
+  }
+  for (; arg < argc; arg++) {
+    struct block_device *dev = blk_find(argv[arg]);
+    if (!dev) {
+      print_string("error: no such device ");
+      print_string(argv[arg]);
+      print_char('\n');
+      continue;
+    }
+    bench_device(dev, mb);
+  }
+}
@@ -0,0 +1,71 @@
+#ifndef KERNEL_BLKDEV_H
+#define KERNEL_BLKDEV_H
+
+// Блочные устройства: общий интерфейс для дисков ATA и массивов RAID-0.
+// Адресация в секторах (sector_size байт), LBA от 0 до sectors - 1.
+
+#include "types.h"
+
+#define BLK_MAX_DEVICES 8
+#define BLK_NAME_MAX 8
+
+#define BLK_EIO -1
+#define BLK_EBUSY -2 // канал занят другим запросом, повторить позже
+#define BLK_PENDING 1
+
+struct block_device;
+
+// Запрос для асинхронной пары submit/poll
+struct blk_request {
+  uint32_t lba;
+  uint8_t *buf;
+  uint32_t count;
+  int write;
+  int status;        // BLK_PENDING, 0 или BLK_EIO
+  uint32_t done;     // передано секторов
+  uint32_t cmd_left; // секторов в текущей команде драйвера
+  uint32_t spins;    // опросов без прогресса
+};
+
+struct block_ops {
+  const char *name;
+  int (*read)(struct block_device *dev, uint32_t lba, void *buf,
+              uint32_t count);
+  int (*write)(struct block_device *dev, uint32_t lba, const void *buf,
+               uint32_t count);
+  int (*flush)(struct block_device *dev);
+  // Необязательно: submit выдаёт запрос и сразу возвращается, poll
+  // продвигает его и возвращает 1, когда rq->status готов
+  int (*submit)(struct block_device *dev, struct blk_request *rq);
+  int (*poll)(struct block_device *dev, struct blk_request *rq);
+};
+
+struct block_device {
+  char name[BLK_NAME_MAX];
+  uint32_t sectors;
+  uint32_t sector_size;
+  const struct block_ops *ops;
+  void *priv;
+};
+
+extern struct block_device *blk_devices[BLK_MAX_DEVICES];
+extern int blk_count;
+
+int blk_register(struct block_device *dev);
+struct block_device *blk_find(const char *name);
+
+int blk_read(struct block_device *dev, uint32_t lba, void *buf,
+             uint32_t count);
+int blk_write(struct block_device *dev, uint32_t lba, const void *buf,
+              uint32_t count);
+int blk_flush(struct block_device *dev);
+
+// Без submit у драйвера запрос выполняется синхронно внутри blk_submit
+int blk_submit(struct block_device *dev, struct blk_request *rq);
+int blk_poll(struct block_device *dev, struct blk_request *rq);
+
+void cmd_lsblk(int argc, char **argv);
+void cmd_raid(int argc, char **argv);
+void cmd_blkbench(int argc, char **argv);
+
+#endif
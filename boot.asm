@@ -4,14 +4,24 @@ bits 32
 section .multiboot
 align 4
     dd 0x1BADB002          ; Магическое число
-    dd 0x00000003          ; Флаги (выровнять + информация о памяти)
-    dd -(0x1BADB002 + 0x03) ; Контрольная сумма
+    dd 0x00000007          ; Флаги (выровнять + память + видеорежим)
+    dd -(0x1BADB002 + 0x07) ; Контрольная сумма
+    dd 0, 0, 0, 0, 0       ; Адреса загрузки (не нужны для ELF)
+    dd 0                   ; Линейный кадровый буфер
+    dd 1024, 768, 32       ; Желаемый режим; загрузчик может дать другой
 
 section .text
 global start
 extern os_main  ; точка входа C-кода
+extern boot_tsc_start ; bootlog.c: первая отметка трассы загрузки
 
 start:
+    mov esi, eax            ; rdtsc затирает eax (magic) и edx
+    mov edi, ebx            ; Адрес multiboot_info
+    rdtsc                   ; Отметка начала загрузки
+    mov [boot_tsc_start], eax
+    mov [boot_tsc_start + 4], edx
+
     cli                     ; Отключить прерывания
     
     ; Установка стека
@@ -21,7 +31,9 @@ start:
     push 0
     popf
     
-    ; Вызов основной C-функции
+    ; Вызов основной C-функции: os_main(magic, multiboot_info)
+    push edi
+    push esi
     call os_main
     
     ; Если os_main вернется (не должно быть)
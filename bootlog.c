@@ -0,0 +1,108 @@
+#include "bootlog.h"
+#include "ata.h"
+#include "kernel.h"
+#include "stream.h"
+#include "tsc.h"
+
+uint64_t boot_tsc_start = 0;
+
+static struct boot_event events[BOOTLOG_MAX];
+static int event_count = 0;
+
+void bootlog_mark(const char *name) {
+  if (event_count < BOOTLOG_MAX) {
+    events[event_count].name = name;
+    events[event_count].tsc = rdtsc();
+    event_count++;
+  }
+}
+
+static uint64_t bootlog_base(void) {
+  if (boot_tsc_start || event_count == 0) {
+    return boot_tsc_start;
+  }
+  return events[0].tsc;
+}
+
+uint32_t bootlog_total_us(void) {
+  if (event_count == 0) {
+    return 0;
+  }
+  return tsc_to_us(events[event_count - 1].tsc - bootlog_base());
+}
+
+static char *put_uint(char *p, uint32_t value, int width) {
+  char digits[10];
+  int n = 0;
+  do {
+    digits[n++] = '0' + value % 10;
+    value /= 10;
+  } while (value);
+  for (; width > n; width--) {
+    *p++ = ' ';
+  }
+  while (n > 0) {
+    *p++ = digits[--n];
+  }
+  return p;
+}
+
+static char *put_str(char *p, char *end, const char *str) {
+  while (*str && p < end) {
+    *p++ = *str++;
+  }
+  return p;
+}
+
+static void bootlog_line(void (*out)(char *), uint32_t at_us, uint32_t us,
+                         const char *name) {
+  char line[80];
+  char *end = line + sizeof(line) - 2;
+  char *p = put_uint(line, at_us / 1000, 6);
+  *p++ = '.';
+  *p++ = '0' + at_us % 1000 / 100;
+  *p++ = '0' + at_us % 100 / 10;
+  *p++ = '0' + at_us % 10;
+  p = put_str(p, end, " ms");
+  p = put_uint(p, us, 10);
+  p = put_str(p, end, " us  ");
+  p = put_str(p, end, name);
+  *p++ = '\n';
+  *p = '\0';
+  out(line);
+}
+
+// Время от start и длительность фазы, закончившейся отметкой
+void bootlog_print(void (*out)(char *str)) {
+  uint64_t base = bootlog_base();
+  uint64_t prev = base;
+
+  out("  since start        phase  name\n");
+  if (boot_tsc_start) {
+    bootlog_line(out, 0, 0, "start");
+  }
+  for (int i = 0; i < event_count; i++) {
+    bootlog_line(out, tsc_to_us(events[i].tsc - base),
+                 tsc_to_us(events[i].tsc - prev), events[i].name);
+    prev = events[i].tsc;
+  }
+}
+
+// bootlog -p: опрос дисков по очереди против обоих каналов сразу
+void cmd_bootlog(int argc, char **argv) {
+  if (argc < 2) {
+    bootlog_print(sh_print);
+    return;
+  }
+  if (strcmp(argv[1], "-p") != 0) {
+    print_string("usage: bootlog [-p]\n");
+    return;
+  }
+  uint32_t serial_us = tsc_to_us(ata_probe_cycles(0));
+  uint32_t parallel_us = tsc_to_us(ata_probe_cycles(1));
+  sh_print("ata probe: one drive at a time ");
+  sh_print_uint(serial_us);
+  sh_print(" us, both channels at once ");
+  sh_print_uint(parallel_us);
+  sh_print(" us\n");
+}
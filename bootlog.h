@@ -0,0 +1,31 @@
+#ifndef KERNEL_BOOTLOG_H
+#define KERNEL_BOOTLOG_H
+
+// Трасса загрузки: отметки TSC в конце каждой фазы. Первая отметка
+// ставится первой инструкцией start в boot.asm, остальные - bootlog_mark.
+// Такты переводятся во время только при выводе, поэтому отмечать можно и
+// до калибровки TSC.
+
+#include "types.h"
+
+#define BOOTLOG_MAX 32
+
+struct boot_event {
+  const char *name;
+  uint64_t tsc;
+};
+
+// Пишется в boot.asm; 0, если boot.o собран без отметки
+extern uint64_t boot_tsc_start;
+
+void bootlog_mark(const char *name);
+
+// От start (или первой отметки) до последней отметки
+uint32_t bootlog_total_us(void);
+
+// Таблица фаз построчно через out (sh_print, serial_print)
+void bootlog_print(void (*out)(char *str));
+
+void cmd_bootlog(int argc, char **argv);
+
+#endif
@@ -0,0 +1,147 @@
+#include "compress.h"
+#include "ata.h"
+#include "kernel.h"
+#include "lz.h"
+#include "tsc.h"
+
+#define CHUNK_BLOCKS (FS_CHUNK_SIZE / BLOCK_SIZE)
+
+// Два блока карты кусков: смещения offsets[i] и offsets[i + 1] могут
+// оказаться по разные стороны границы блока. Последовательное чтение
+// обращается к одному и тому же блоку карты много раз подряд
+static struct {
+  uint32_t lba;
+  int valid;
+  uint8_t data[2 * BLOCK_SIZE];
+} map_cache;
+
+// Сжатый кусок занимает не больше CHUNK_BLOCKS + 1 блоков
+static uint8_t zbuf[FS_CHUNK_SIZE + BLOCK_SIZE];
+
+static int chunk_range(struct DiskFileEntry *file, uint32_t index,
+                       uint32_t *start, uint32_t *end) {
+  uint32_t pos = index * sizeof(uint32_t);
+  uint32_t block = pos / BLOCK_SIZE;
+  uint32_t lba = file->start_block + block;
+
+  if (!map_cache.valid || map_cache.lba != lba) {
+    uint32_t count = block + 2 <= file->blocks_count ? 2 : 1;
+    ata_read_blocks(lba, map_cache.data, count);
+    map_cache.lba = lba;
+    map_cache.valid = 1;
+  }
+  uint32_t *offsets = (uint32_t *)(map_cache.data + pos % BLOCK_SIZE);
+  *start = offsets[0];
+  *end = offsets[1];
+  return *start < *end && *end - *start <= FS_CHUNK_SIZE &&
+                 *end <= file->blocks_count * BLOCK_SIZE
+             ? 0
+             : -1;
+}
+
+int fs_read_chunk(struct DiskFileEntry *file, uint32_t index, uint8_t *page) {
+  uint32_t offset = index * FS_CHUNK_SIZE;
+  uint32_t len = offset < file->size ? file->size - offset : 0;
+  if (len > FS_CHUNK_SIZE) {
+    len = FS_CHUNK_SIZE;
+  }
+
+  if (len > 0 && !(file->flags & FS_FILE_COMPRESSED)) {
+    uint32_t count = (len + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    ata_read_blocks(file->start_block + index * CHUNK_BLOCKS, page, count);
+  } else if (len > 0) {
+    uint32_t start, end;
+    if (chunk_range(file, index, &start, &end) != 0) {
+      memset(page, 0, FS_CHUNK_SIZE);
+      return -1;
+    }
+    uint32_t first = start / BLOCK_SIZE;
+    uint32_t count = (end + BLOCK_SIZE - 1) / BLOCK_SIZE - first;
+    ata_read_blocks(file->start_block + first, zbuf, count);
+
+    uint8_t *data = zbuf + start % BLOCK_SIZE;
+    if (end - start == len) {
+      mem_cpy(page, data, len); // кусок не сжался и лежит как есть
+    } else if (lz_decompress(data, end - start, page, len) != (int)len) {
+      memset(page, 0, FS_CHUNK_SIZE);
+      return -1;
+    }
+  }
+  memset(page + len, 0, FS_CHUNK_SIZE - len);
+  return 0;
+}
+
+uint32_t fs_ratio10(struct DiskFileEntry *file) {
+  uint64_t stored = (uint64_t)file->blocks_count * BLOCK_SIZE;
+  if (stored == 0) {
+    return 10;
+  }
+  return (uint32_t)udiv64((uint64_t)file->size * 10 + stored / 2,
+                          (uint32_t)stored);
+}
+
+static void print_bench(char *label, uint32_t bytes, uint32_t us) {
+  print_string(label);
+  print_uint(us);
+  print_string(" us, ");
+  print_throughput(bytes, us);
+  print_char('\n');
+}
+
+// zbench <file>: чтение несжатого объёма файла прямо с диска против чтения
+// сжатых кусков с распаковкой. Page cache не участвует, оба прохода холодные
+void cmd_zbench(int argc, char **argv) {
+  static uint8_t page[FS_CHUNK_SIZE];
+
+  if (argc < 2) {
+    print_string("need file name(zbench <filename>)\n");
+    return;
+  }
+  int inode = hd_mounted ? fs_find_hd(&hd_fs, argv[1]) : -1;
+  if (inode == -1) {
+    print_string("error: file not exist on disk\n");
+    return;
+  }
+  struct DiskFileEntry *file = fs_inode(&hd_fs, inode);
+  uint32_t chunks = fs_chunk_count(file->size);
+
+  // Без сжатия файл занял бы size байт, начиная с того же блока
+  uint32_t raw_blocks = (file->size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  if (file->start_block + raw_blocks > boot_disk->sectors) {
+    raw_blocks = boot_disk->sectors - file->start_block;
+  }
+  uint64_t start = rdtsc();
+  for (uint32_t block = 0; block < raw_blocks; block += CHUNK_BLOCKS) {
+    uint32_t count = raw_blocks - block;
+    if (count > CHUNK_BLOCKS) {
+      count = CHUNK_BLOCKS;
+    }
+    ata_read_blocks(file->start_block + block, page, count);
+  }
+  print_bench("plain read: ", raw_blocks * BLOCK_SIZE,
+              tsc_to_us(rdtsc() - start));
+
+  map_cache.valid = 0;
+  start = rdtsc();
+  for (uint32_t i = 0; i < chunks; i++) {
+    if (fs_read_chunk(file, i, page) != 0) {
+      print_string("error: bad chunk ");
+      print_uint(i);
+      print_char('\n');
+      return;
+    }
+  }
+  uint32_t us = tsc_to_us(rdtsc() - start);
+  uint32_t ratio = fs_ratio10(file);
+  print_string(file->flags & FS_FILE_COMPRESSED ? "compressed (" : "stored (");
+  print_uint(file->blocks_count * BLOCK_SIZE);
+  print_string(" bytes on disk, ");
+  print_uint(ratio / 10);
+  print_char('.');
+  print_uint(ratio % 10);
+  print_string("x): ");
+  print_uint(us);
+  print_string(" us, effective ");
+  print_throughput(file->size, us);
+  print_char('\n');
+}
@@ -0,0 +1,19 @@
+#ifndef KERNEL_COMPRESS_H
+#define KERNEL_COMPRESS_H
+
+// Чтение файлов диска по кускам FS_CHUNK_SIZE: обычных - блоками как есть,
+// сжатых - через карту кусков и распаковку только нужного куска.
+
+#include "fs.h"
+#include "types.h"
+
+// Кусок index файла в page (FS_CHUNK_SIZE байт, хвост за концом файла
+// заполняется нулями). 0 - успех, -1 - повреждённый кусок
+int fs_read_chunk(struct DiskFileEntry *file, uint32_t index, uint8_t *page);
+
+// Степень сжатия * 10 (несжатый размер к занятому на диске)
+uint32_t fs_ratio10(struct DiskFileEntry *file);
+
+void cmd_zbench(int argc, char **argv);
+
+#endif
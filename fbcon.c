@@ -0,0 +1,383 @@
+#include "fbcon.h"
+#include "irq.h"
+#include "kernel.h"
+#include "paging.h"
+#include "tsc.h"
+
+#define CPUID_FXSR (1 << 24)
+#define CPUID_SSE2 (1 << 26)
+#define CR0_MP 0x2
+#define CR0_EM 0x4
+#define CR4_OSFXSR 0x200
+#define CR4_OSXMMEXCPT 0x400
+
+#define CURSOR_FIRST_ROW 14 // курсор - подчёркивание в двух нижних строках
+#define CELL_UNDRAWN 0xFFFF
+#define BOX_GLYPH (FONT_GLYPHS - 1)
+
+#define BENCH_LINES 200
+#define BENCH_LINE_LEN 64
+#define BENCH_REDRAWS 8
+
+struct fb_info {
+  uint32_t phys;
+  uint32_t pitch;
+  uint32_t width;
+  uint32_t height;
+  uint8_t red_pos, red_size;
+  uint8_t green_pos, green_size;
+  uint8_t blue_pos, blue_size;
+};
+
+static struct fb_info fb;
+static uint8_t *fb_base;
+static int cols, rows;
+static int cursor_pos = -1;
+
+// Что сейчас в vidmem и что уже нарисовано: (атрибут << 8) | символ
+static uint16_t cells[FBCON_MAX_COLS * FBCON_MAX_ROWS];
+static uint16_t drawn[FBCON_MAX_COLS * FBCON_MAX_ROWS];
+
+static uint32_t palette[16];
+static const uint8_t vga_rgb[16][3] = {
+    {0x00, 0x00, 0x00}, {0x00, 0x00, 0xAA}, {0x00, 0xAA, 0x00},
+    {0x00, 0xAA, 0xAA}, {0xAA, 0x00, 0x00}, {0xAA, 0x00, 0xAA},
+    {0xAA, 0x55, 0x00}, {0xAA, 0xAA, 0xAA}, {0x55, 0x55, 0x55},
+    {0x55, 0x55, 0xFF}, {0x55, 0xFF, 0x55}, {0x55, 0xFF, 0xFF},
+    {0xFF, 0x55, 0x55}, {0xFF, 0x55, 0xFF}, {0xFF, 0xFF, 0x55},
+    {0xFF, 0xFF, 0xFF},
+};
+
+// Маски четырёх точек для тетрады строки глифа (старший бит - левая
+// точка) и цвета текущей ячейки: строка глифа - две 16-байтные записи
+static uint32_t nibble_mask[16][4] __attribute__((aligned(16)));
+static struct {
+  uint32_t fg[4];
+  uint32_t bg[4];
+} glyph_colors __attribute__((aligned(16)));
+
+int fbcon_active = 0;
+static int sse2_enabled = 0;
+static int use_sse2 = 0;
+struct fbcon_stats fbcon_stats;
+
+char *fbcon_probe(uint32_t magic, struct multiboot_info *mbi, int *out_cols,
+                  int *out_rows) {
+  if (magic != MULTIBOOT_BOOTLOADER_MAGIC ||
+      !(mbi->flags & MULTIBOOT_INFO_FRAMEBUFFER)) {
+    return NULL;
+  }
+  if (mbi->framebuffer_type != MULTIBOOT_FRAMEBUFFER_TYPE_RGB ||
+      mbi->framebuffer_bpp != 32 || mbi->framebuffer_addr_high != 0) {
+    return NULL;
+  }
+  fb.phys = mbi->framebuffer_addr_low;
+  fb.pitch = mbi->framebuffer_pitch;
+  fb.width = mbi->framebuffer_width;
+  fb.height = mbi->framebuffer_height;
+  fb.red_pos = mbi->framebuffer_red_field_position;
+  fb.red_size = mbi->framebuffer_red_mask_size;
+  fb.green_pos = mbi->framebuffer_green_field_position;
+  fb.green_size = mbi->framebuffer_green_mask_size;
+  fb.blue_pos = mbi->framebuffer_blue_field_position;
+  fb.blue_size = mbi->framebuffer_blue_mask_size;
+
+  cols = fb.width / FONT_WIDTH;
+  rows = fb.height / FONT_HEIGHT;
+  if (cols > FBCON_MAX_COLS) {
+    cols = FBCON_MAX_COLS;
+  }
+  if (rows > FBCON_MAX_ROWS) {
+    rows = FBCON_MAX_ROWS;
+  }
+  if (cols == 0 || rows == 0) {
+    return NULL;
+  }
+  *out_cols = cols;
+  *out_rows = rows;
+  return (char *)cells;
+}
+
+static uint32_t rgb_pixel(const uint8_t *rgb) {
+  return ((uint32_t)(rgb[0] >> (8 - fb.red_size)) << fb.red_pos) |
+         ((uint32_t)(rgb[1] >> (8 - fb.green_size)) << fb.green_pos) |
+         ((uint32_t)(rgb[2] >> (8 - fb.blue_size)) << fb.blue_pos);
+}
+
+// SSE нужно разрешить в CR4, иначе movdqa даёт #UD. CR4.OSFXSR включает
+// SSE и для ring 3, а состояние FPU/SSE при переходах не сохраняется,
+// поэтому blit_glyph_sse2 сам сохраняет регистры, которые портит
+static int sse2_init(void) {
+  uint32_t eax = 1, ebx, ecx, edx;
+  __asm__ volatile("cpuid" : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+  if ((edx & (CPUID_FXSR | CPUID_SSE2)) != (CPUID_FXSR | CPUID_SSE2)) {
+    return 0;
+  }
+  uint32_t cr0, cr4;
+  __asm__ volatile("mov %%cr0, %0" : "=r"(cr0));
+  cr0 = (cr0 & ~CR0_EM) | CR0_MP;
+  __asm__ volatile("mov %0, %%cr0" : : "r"(cr0));
+  __asm__ volatile("mov %%cr4, %0" : "=r"(cr4));
+  cr4 |= CR4_OSFXSR | CR4_OSXMMEXCPT;
+  __asm__ volatile("mov %0, %%cr4" : : "r"(cr4));
+  return 1;
+}
+
+// Без PCD: тип памяти кадрового буфера (обычно WC) задают MTRR
+int fbcon_enable(void) {
+  if (cols == 0) {
+    return -1;
+  }
+  uint32_t size = fb.pitch * fb.height;
+  fb_base = paging_enabled ? vmap(fb.phys, size, 0) : (uint8_t *)fb.phys;
+  if (!fb_base) {
+    return -1;
+  }
+  for (int i = 0; i < 16; i++) {
+    palette[i] = rgb_pixel(vga_rgb[i]);
+    for (int px = 0; px < 4; px++) {
+      nibble_mask[i][px] = (i & (8 >> px)) ? 0xFFFFFFFF : 0;
+    }
+  }
+  sse2_enabled = use_sse2 = sse2_init();
+
+  // Поля справа и снизу от сетки символов остаются чёрными
+  memset(fb_base, 0, size);
+  for (int pos = 0; pos < cols * rows; pos++) {
+    drawn[pos] = CELL_UNDRAWN;
+  }
+  fbcon_active = 1;
+  fbcon_sync();
+  return 0;
+}
+
+static void blit_glyph(uint8_t *dst, const uint8_t *glyph) {
+  for (int y = 0; y < FONT_HEIGHT; y++, dst += fb.pitch) {
+    uint32_t *px = (uint32_t *)dst;
+    for (int x = 0; x < FONT_WIDTH; x++) {
+      px[x] = (glyph[y] & (0x80 >> x)) ? glyph_colors.fg[0]
+                                       : glyph_colors.bg[0];
+    }
+  }
+}
+
+// Сюда blit_glyph_sse2 сохраняет xmm0-xmm3: print_char вызывается и из
+// sys_write, а регистры принадлежат пользовательскому процессу. Вызовы
+// идут с выключенными прерываниями, одного буфера хватает
+static uint32_t xmm_save[4][4] __attribute__((aligned(16)));
+
+// Строка глифа: (fg & mask) | (bg & ~mask) для 2x4 точек, две записи.
+// Ядро собирается без -msse; target нужен только для списка clobber
+__attribute__((target("sse2"))) static void
+blit_glyph_sse2(uint8_t *dst, const uint8_t *glyph) {
+  __asm__ volatile("movdqa %%xmm0, 0(%0)\n"
+                   "movdqa %%xmm1, 16(%0)\n"
+                   "movdqa %%xmm2, 32(%0)\n"
+                   "movdqa %%xmm3, 48(%0)\n"
+                   :
+                   : "r"(xmm_save)
+                   : "memory");
+  for (int y = 0; y < FONT_HEIGHT; y++, dst += fb.pitch) {
+    __asm__ volatile("movdqa %1, %%xmm0\n"
+                     "movdqa %2, %%xmm1\n"
+                     "movdqa %%xmm0, %%xmm2\n"
+                     "movdqa %%xmm1, %%xmm3\n"
+                     "pand %3, %%xmm0\n"
+                     "pand %3, %%xmm1\n"
+                     "pandn %4, %%xmm2\n"
+                     "pandn %4, %%xmm3\n"
+                     "por %%xmm2, %%xmm0\n"
+                     "por %%xmm3, %%xmm1\n"
+                     "movdqu %%xmm0, (%0)\n"
+                     "movdqu %%xmm1, 16(%0)\n"
+                     :
+                     : "r"(dst), "m"(nibble_mask[glyph[y] >> 4]),
+                       "m"(nibble_mask[glyph[y] & 0xF]),
+                       "m"(glyph_colors.fg), "m"(glyph_colors.bg)
+                     : "xmm0", "xmm1", "xmm2", "xmm3", "memory");
+  }
+  __asm__ volatile("movdqa 0(%0), %%xmm0\n"
+                   "movdqa 16(%0), %%xmm1\n"
+                   "movdqa 32(%0), %%xmm2\n"
+                   "movdqa 48(%0), %%xmm3\n"
+                   :
+                   : "r"(xmm_save)
+                   : "xmm0", "xmm1", "xmm2", "xmm3", "memory");
+}
+
+// Вызывается с выключенными прерываниями
+static void draw(int pos) {
+  uint16_t cell = cells[pos];
+  uint8_t ch = cell & 0xFF;
+  uint8_t attr = cell >> 8;
+  uint8_t underlined[FONT_HEIGHT];
+
+  const uint8_t *glyph;
+  if (ch == 0) {
+    glyph = fbcon_font[0];
+  } else if (ch < FONT_FIRST || ch >= FONT_FIRST + BOX_GLYPH) {
+    glyph = fbcon_font[BOX_GLYPH];
+  } else {
+    glyph = fbcon_font[ch - FONT_FIRST];
+  }
+  if (pos == cursor_pos) {
+    for (int y = 0; y < FONT_HEIGHT; y++) {
+      underlined[y] = y >= CURSOR_FIRST_ROW ? 0xFF : glyph[y];
+    }
+    glyph = underlined;
+  }
+  for (int i = 0; i < 4; i++) {
+    glyph_colors.fg[i] = palette[attr & 0xF];
+    glyph_colors.bg[i] = palette[(attr >> 4) & 0xF];
+  }
+
+  uint8_t *dst = fb_base + (pos / cols) * FONT_HEIGHT * fb.pitch +
+                 (pos % cols) * FONT_WIDTH * sizeof(uint32_t);
+  if (use_sse2) {
+    blit_glyph_sse2(dst, glyph);
+  } else {
+    blit_glyph(dst, glyph);
+  }
+  drawn[pos] = cell;
+  fbcon_stats.cells_drawn++;
+}
+
+void fbcon_draw_cell(int pos) {
+  if (!fbcon_active || pos < 0 || pos >= cols * rows) {
+    return;
+  }
+  uint32_t flags = irq_save();
+  draw(pos);
+  irq_restore(flags);
+}
+
+// После прокрутки совпадают, например, пустые строки и повторы: они не
+// рисуются, а в изменившейся строке рисуются только другие ячейки
+void fbcon_sync(void) {
+  if (!fbcon_active) {
+    return;
+  }
+  uint32_t flags = irq_save();
+  for (int y = 0; y < rows; y++) {
+    int changed = 0;
+    for (int pos = y * cols; pos < (y + 1) * cols; pos++) {
+      if (cells[pos] != drawn[pos]) {
+        draw(pos);
+        changed = 1;
+      }
+    }
+    if (changed) {
+      fbcon_stats.rows_redrawn++;
+    } else {
+      fbcon_stats.rows_skipped++;
+    }
+  }
+  irq_restore(flags);
+}
+
+void fbcon_cursor(int x, int y) {
+  int pos = y * cols + x;
+  if (!fbcon_active || pos == cursor_pos) {
+    return;
+  }
+  if (x >= cols || pos >= cols * rows) {
+    pos = -1;
+  }
+  uint32_t flags = irq_save();
+  int old = cursor_pos;
+  cursor_pos = pos;
+  if (old >= 0) {
+    draw(old);
+  }
+  if (pos >= 0) {
+    draw(pos);
+  }
+  irq_restore(flags);
+}
+
+// Весь экран заново: все ячейки считаются не нарисованными
+static uint32_t redraw_us(void) {
+  uint64_t start = rdtsc();
+  for (int i = 0; i < BENCH_REDRAWS; i++) {
+    for (int pos = 0; pos < cols * rows; pos++) {
+      drawn[pos] = CELL_UNDRAWN;
+    }
+    fbcon_sync();
+  }
+  return tsc_to_us(rdtsc() - start) / BENCH_REDRAWS;
+}
+
+// Вывод символов с прокруткой и перерисовка всего экрана. В текстовом
+// режиме те же замеры идут через VGA 0xB8000 - для сравнения запусков
+void cmd_fbbench(int argc, char **argv) {
+  struct fbcon_stats before = fbcon_stats;
+  uint32_t chars = 0;
+
+  uint64_t start = rdtsc();
+  for (int line = 0; line < BENCH_LINES; line++) {
+    for (int i = 0; i < BENCH_LINE_LEN; i++) {
+      print_char('!' + (line + i) % 94);
+    }
+    print_char('\n');
+    chars += BENCH_LINE_LEN + 1;
+  }
+  uint32_t print_us = tsc_to_us(rdtsc() - start);
+  if (print_us == 0) {
+    print_us = 1;
+  }
+  struct fbcon_stats after = fbcon_stats;
+
+  uint32_t plain_us = 0, sse2_us = 0;
+  if (fbcon_active) {
+    int saved = use_sse2;
+    use_sse2 = 0;
+    plain_us = redraw_us();
+    if (sse2_enabled) {
+      use_sse2 = 1;
+      sse2_us = redraw_us();
+    }
+    use_sse2 = saved;
+  } else {
+    start = rdtsc();
+    for (int i = 0; i < BENCH_REDRAWS; i++) {
+      clean_screen();
+    }
+    plain_us = tsc_to_us(rdtsc() - start) / BENCH_REDRAWS;
+  }
+  clean_screen();
+
+  if (fbcon_active) {
+    print_string("framebuffer ");
+    print_uint(fb.width);
+    print_char('x');
+    print_uint(fb.height);
+  } else {
+    print_string("VGA text");
+  }
+  print_string(", ");
+  print_uint(console_cols);
+  print_char('x');
+  print_uint(console_rows);
+  print_string(" cells\n");
+
+  print_uint(chars);
+  print_string(" chars with scrolling: ");
+  print_uint((uint32_t)udiv64((uint64_t)chars * 1000000, print_us));
+  print_string(" chars/s\n");
+  print_string("full-screen redraw: ");
+  print_uint(plain_us);
+  print_string(" us");
+  if (sse2_us) {
+    print_string(" scalar, ");
+    print_uint(sse2_us);
+    print_string(" us sse2");
+  }
+  print_char('\n');
+  if (fbcon_active) {
+    print_string("scroll rows redrawn ");
+    print_uint(after.rows_redrawn - before.rows_redrawn);
+    print_string(", unchanged ");
+    print_uint(after.rows_skipped - before.rows_skipped);
+    print_char('\n');
+  }
+}
@@ -0,0 +1,50 @@
+#ifndef KERNEL_FBCON_H
+#define KERNEL_FBCON_H
+
+// Консоль на линейном кадровом буфере VBE (32 бита на точку), который
+// выставляет загрузчик по флагу видеорежима в заголовке multiboot.
+// Текст хранится так же, как в текстовом режиме VGA: пары (символ,
+// атрибут) в vidmem; fbcon рисует изменившиеся ячейки шрифтом 8x16 и
+// помнит, что уже на экране, поэтому прокрутка перерисовывает только
+// строки, которые действительно поменялись.
+
+#include "multiboot.h"
+#include "types.h"
+
+#define FONT_WIDTH 8
+#define FONT_HEIGHT 16
+#define FONT_FIRST 32  // первый символ шрифта
+#define FONT_GLYPHS 96 // 32-126 и рамка для остальных
+
+#define FBCON_MAX_COLS 160
+#define FBCON_MAX_ROWS 64
+
+struct fbcon_stats {
+  uint32_t cells_drawn;
+  uint32_t rows_redrawn; // fbcon_sync: строки с изменениями
+  uint32_t rows_skipped; // fbcon_sync: строки без изменений
+};
+
+extern const uint8_t fbcon_font[FONT_GLYPHS][FONT_HEIGHT];
+extern int fbcon_active;
+extern struct fbcon_stats fbcon_stats;
+
+// Загрузчик выставил режим RGB 32bpp: буфер ячеек консоли и её размер в
+// символах; NULL - остаёмся в текстовом режиме. На экран буфер попадает
+// после fbcon_enable
+char *fbcon_probe(uint32_t magic, struct multiboot_info *mbi, int *cols,
+                  int *rows);
+
+// Отображение кадрового буфера (после paging_init); 0 - консоль рисует
+int fbcon_enable(void);
+
+// Ячейка pos (y * cols + x) буфера изменилась
+void fbcon_draw_cell(int pos);
+
+// Перерисовать ячейки, которые отличаются от нарисованных
+void fbcon_sync(void);
+void fbcon_cursor(int x, int y);
+
+void cmd_fbbench(int argc, char **argv);
+
+#endif
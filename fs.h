@@ -0,0 +1,82 @@
+#ifndef KERNEL_FS_H
+#define KERNEL_FS_H
+
+// Формат диска KeprOS. Общий для ядра (kernel.c) и утилиты tools/mkkeprfs.c
+
+#ifdef KEPROS_HOST
+#include <stdint.h>
+#else
+#include "types.h"
+#endif
+
+#define FS_MAGIC 0x5250454B // "KEPR"
+#define BLOCK_SIZE 512
+
+// Для диска ~1MB (2048 блоков по 512 байт)
+#define TOTAL_BLOCKS 2048
+#define BITMAP_SIZE ((TOTAL_BLOCKS + 7) / 8) // = 256 байт
+#define BITMAP_BLOCKS 1 // 256 байт умещается в 1 блок 512 байт
+#define BITS_PER_BITMAP_BLOCK (BLOCK_SIZE * 8)
+
+// Расположение на диске по умолчанию (для образа на TOTAL_BLOCKS блоков).
+// Для образов другого размера mkkeprfs считает расположение сам и
+// записывает его в суперблок (bitmap_start, inode_start, data_start).
+#define SUPERBLOCK_LBA 0   // Суперблок
+#define BITMAP_LBA 1       // Битовая карта (1 блок)
+#define SUMMARY_LBA 2      // Свободные блоки по группам (1 блок)
+#define INODE_TABLE_LBA 3  // Таблица файлов (начинается с блока 3)
+#define DATA_REGION_LBA 11 // Данные файлов (начинаются с блока 11)
+
+#define INODES_PER_BLOCK 8 // Сколько DiskFileEntry помещается в блок
+#define DISK_FILENAME 48
+
+// Группа - блоки, описанные одним блоком битовой карты. Сводка групп -
+// uint32_t свободных блоков на группу, блоки [summary_start, inode_start)
+#define BLOCKS_PER_GROUP BITS_PER_BITMAP_BLOCK
+#define GROUP_ENTRIES_PER_BLOCK (BLOCK_SIZE / sizeof(uint32_t))
+
+// state: счётчики free_* и сводка групп верны, только если ФС была
+// корректно размонтирована. У образов старого формата поле равно 0
+#define FS_STATE_CLEAN 1
+
+// Занятые inode идут подряд с нулевого и отсортированы по имени
+#define FS_FEATURE_SORTED 0x1
+
+struct SuperBlock {
+  uint32_t magic;
+  uint32_t total_blocks;
+  uint32_t free_blocks;
+  uint32_t bitmap_start;
+  uint32_t inode_start;
+  uint32_t data_start;
+  uint32_t inode_count;
+  uint32_t free_inodes;
+  uint32_t state;
+  uint32_t features;
+  uint32_t summary_start; // 0 - сводки групп нет
+  uint32_t group_count;
+};
+
+// Сжатый файл (флаг FS_FILE_COMPRESSED) хранится кусками по FS_CHUNK_SIZE
+// несжатых байт. Отрезок начинается с карты кусков uint32_t[chunks + 1]:
+// смещения кусков в байтах от начала отрезка, последнее - конец данных.
+// Кусок в формате lz.h; кусок, длина которого равна несжатой, лежит как есть.
+#define FS_FILE_COMPRESSED 0x01
+#define FS_CHUNK_SIZE 4096
+#define fs_chunk_count(size) (((size) + FS_CHUNK_SIZE - 1) / FS_CHUNK_SIZE)
+
+// Файл занимает непрерывный отрезок блоков [start_block, +blocks_count)
+struct DiskFileEntry {
+  char name[DISK_FILENAME];
+  uint32_t size; // несжатый размер
+  uint32_t start_block;
+  uint32_t blocks_count;
+  uint8_t is_used;
+  uint8_t flags;
+  uint8_t reserved[2];
+};
+
+_Static_assert(sizeof(struct DiskFileEntry) * INODES_PER_BLOCK == BLOCK_SIZE,
+               "DiskFileEntry must pack INODES_PER_BLOCK per block");
+
+#endif
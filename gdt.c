@@ -0,0 +1,72 @@
+#include "gdt.h"
+#include "kernel.h"
+
+struct gdt_entry {
+  uint16_t limit_low;
+  uint16_t base_low;
+  uint8_t base_mid;
+  uint8_t access;
+  uint8_t granularity;
+  uint8_t base_high;
+} __attribute__((packed));
+
+struct gdt_ptr {
+  uint16_t limit;
+  uint32_t base;
+} __attribute__((packed));
+
+struct tss {
+  uint32_t prev_tss;
+  uint32_t esp0;
+  uint32_t ss0;
+  uint32_t unused[22];
+  uint16_t trap;
+  uint16_t iomap_base;
+} __attribute__((packed));
+
+static struct gdt_entry gdt[6];
+static struct tss tss;
+
+static void gdt_set(int i, uint32_t base, uint32_t limit, uint8_t access,
+                    uint8_t flags) {
+  gdt[i].limit_low = limit & 0xFFFF;
+  gdt[i].base_low = base & 0xFFFF;
+  gdt[i].base_mid = (base >> 16) & 0xFF;
+  gdt[i].access = access;
+  gdt[i].granularity = (flags << 4) | ((limit >> 16) & 0x0F);
+  gdt[i].base_high = base >> 24;
+}
+
+void tss_set_kernel_stack(uint32_t esp0) { tss.esp0 = esp0; }
+
+void gdt_init(void) {
+  struct gdt_ptr ptr;
+
+  gdt_set(0, 0, 0, 0, 0);
+  gdt_set(1, 0, 0xFFFFF, 0x9A, 0xC); // код ядра
+  gdt_set(2, 0, 0xFFFFF, 0x92, 0xC); // данные ядра
+  gdt_set(3, 0, 0xFFFFF, 0xFA, 0xC); // код пользователя
+  gdt_set(4, 0, 0xFFFFF, 0xF2, 0xC); // данные пользователя
+  gdt_set(5, (uint32_t)&tss, sizeof(tss) - 1, 0x89, 0x0);
+
+  memset(&tss, 0, sizeof(tss));
+  tss.ss0 = KERNEL_DS;
+  tss.iomap_base = sizeof(tss);
+
+  ptr.limit = sizeof(gdt) - 1;
+  ptr.base = (uint32_t)gdt;
+  __asm__ volatile("lgdt %0\n"
+                   "ljmp $0x08, $1f\n"
+                   "1:\n"
+                   "mov $0x10, %%ax\n"
+                   "mov %%ax, %%ds\n"
+                   "mov %%ax, %%es\n"
+                   "mov %%ax, %%fs\n"
+                   "mov %%ax, %%gs\n"
+                   "mov %%ax, %%ss\n"
+                   "mov $0x28, %%ax\n"
+                   "ltr %%ax\n"
+                   :
+                   : "m"(ptr)
+                   : "eax", "memory");
+}
@@ -0,0 +1,148 @@
+#include "idt.h"
+#include "kernel.h"
+#include "process.h"
+
+struct idt_entry {
+  uint16_t offset_low;
+  uint16_t selector;
+  uint8_t zero;
+  uint8_t flags;
+  uint16_t offset_high;
+} __attribute__((packed));
+
+struct idt_ptr {
+  uint16_t limit;
+  uint32_t base;
+} __attribute__((packed));
+
+static struct idt_entry idt[IDT_ENTRIES];
+static isr_handler_t handlers[IDT_ENTRIES];
+isr_handler_t user_exception_handler = NULL;
+
+extern uint32_t isr_stub_table[ISR_STUBS];
+extern uint32_t irq_stub_table[IRQ_STUBS];
+extern char isr128[];
+
+// Заглушки: кладут в стек (ошибку) и номер вектора и прыгают в isr_common.
+// Исключения 8, 10-14, 17, 21 кладут код ошибки сами.
+__asm__(".macro ISR_NOERR n\n"
+        "isr\\n:\n"
+        "  pushl $0\n"
+        "  pushl $\\n\n"
+        "  jmp isr_common\n"
+        ".endm\n"
+        ".macro ISR_ERR n\n"
+        "isr\\n:\n"
+        "  pushl $\\n\n"
+        "  jmp isr_common\n"
+        ".endm\n"
+        ".text\n"
+        ".irp n,0,1,2,3,4,5,6,7,9,15,16,18,19,20,22,23,24,25,26,27,28,29,30,31\n"
+        "  ISR_NOERR \\n\n"
+        ".endr\n"
+        ".irp n,8,10,11,12,13,14,17,21\n"
+        "  ISR_ERR \\n\n"
+        ".endr\n"
+        ".irp n,32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47\n"
+        "  ISR_NOERR \\n\n"
+        ".endr\n"
+        "ISR_NOERR 128\n"
+        "isr_common:\n"
+        "  pushal\n"
+        "  pushl %ds\n"
+        "  pushl %es\n"
+        "  pushl %fs\n"
+        "  pushl %gs\n"
+        "  movw $0x10, %ax\n" // KERNEL_DS, если пришли из ring 3
+        "  movw %ax, %ds\n"
+        "  movw %ax, %es\n"
+        "  pushl %esp\n"
+        "  call isr_dispatch\n"
+        "  addl $4, %esp\n"
+        "  popl %gs\n"
+        "  popl %fs\n"
+        "  popl %es\n"
+        "  popl %ds\n"
+        "  popal\n"
+        "  addl $8, %esp\n"
+        "  iret\n"
+        ".data\n"
+        ".globl isr_stub_table\n"
+        "isr_stub_table:\n"
+        ".irp n,0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,"
+        "23,24,25,26,27,28,29,30,31\n"
+        "  .long isr\\n\n"
+        ".endr\n"
+        ".globl irq_stub_table\n"
+        "irq_stub_table:\n"
+        ".irp n,32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47\n"
+        "  .long isr\\n\n"
+        ".endr\n"
+        ".text\n");
+
+static const char *exception_names[ISR_STUBS] = {
+    "divide error",  "debug",          "NMI",          "breakpoint",
+    "overflow",      "bound range",    "invalid opcode", "no FPU",
+    "double fault",  "FPU segment",    "invalid TSS",  "segment not present",
+    "stack fault",   "general protection", "page fault", "reserved",
+    "FPU error",     "alignment check", "machine check", "SIMD error",
+};
+
+void idt_set_gate(uint8_t vector, uint32_t handler, uint8_t flags) {
+  uint16_t cs;
+  __asm__ volatile("mov %%cs, %0" : "=r"(cs));
+
+  idt[vector].offset_low = handler & 0xFFFF;
+  idt[vector].selector = cs;
+  idt[vector].zero = 0;
+  idt[vector].flags = flags;
+  idt[vector].offset_high = handler >> 16;
+}
+
+void idt_set_handler(uint8_t vector, isr_handler_t handler) {
+  handlers[vector] = handler;
+}
+
+void isr_dispatch(struct regs *r) {
+  if (handlers[r->vector]) {
+    handlers[r->vector](r);
+    return;
+  }
+
+  if ((r->cs & 3) == 3 && user_exception_handler && process_running()) {
+    user_exception_handler(r);
+    return;
+  }
+
+  print_string("\nKERNEL PANIC: ");
+  if (r->vector < ISR_STUBS && exception_names[r->vector]) {
+    print_string((char *)exception_names[r->vector]);
+  } else {
+    print_string("unexpected interrupt ");
+    print_uint(r->vector);
+  }
+  print_string(" at eip ");
+  print_hex(r->eip);
+  print_string(" err ");
+  print_hex(r->err_code);
+  print_char('\n');
+  for (;;) {
+    __asm__ volatile("cli; hlt");
+  }
+}
+
+void idt_init(void) {
+  struct idt_ptr ptr;
+
+  for (int i = 0; i < ISR_STUBS; i++) {
+    idt_set_gate(i, isr_stub_table[i], IDT_GATE_INT32);
+  }
+  // IRQ 0-15 после перенастройки PIC (irq.c) приходят на векторы 32-47
+  for (int i = 0; i < IRQ_STUBS; i++) {
+    idt_set_gate(ISR_STUBS + i, irq_stub_table[i], IDT_GATE_INT32);
+  }
+  idt_set_gate(SYSCALL_VECTOR, (uint32_t)isr128, IDT_GATE_USER);
+  ptr.limit = sizeof(idt) - 1;
+  ptr.base = (uint32_t)idt;
+  __asm__ volatile("lidt %0" : : "m"(ptr));
+}
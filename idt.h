@@ -0,0 +1,35 @@
+#ifndef KERNEL_IDT_H
+#define KERNEL_IDT_H
+
+// Таблица дескрипторов прерываний и общий обработчик исключений
+
+#include "types.h"
+
+#define IDT_ENTRIES 256
+#define ISR_STUBS 32
+#define IRQ_STUBS 16
+
+#define EXC_PAGE_FAULT 14
+#define SYSCALL_VECTOR 0x80
+
+#define IDT_GATE_INT32 0x8E // present, DPL 0, 32-битный шлюз прерывания
+#define IDT_GATE_USER 0xEE  // то же, но доступен из ring 3 (int 0x80)
+
+// Кадр стека, который строит isr_common (см. idt.c)
+struct regs {
+  uint32_t gs, fs, es, ds;
+  uint32_t edi, esi, ebp, esp_dummy, ebx, edx, ecx, eax;
+  uint32_t vector, err_code;
+  uint32_t eip, cs, eflags, useresp, ss;
+};
+
+typedef void (*isr_handler_t)(struct regs *r);
+
+// Исключения в ring 3 не роняют ядро, а завершают процесс
+extern isr_handler_t user_exception_handler;
+
+void idt_init(void);
+void idt_set_gate(uint8_t vector, uint32_t handler, uint8_t flags);
+void idt_set_handler(uint8_t vector, isr_handler_t handler);
+
+#endif
@@ -0,0 +1,129 @@
+#include "irq.h"
+#include "idt.h"
+#include "io.h"
+#include "kernel.h"
+#include "softirq.h"
+#include "tsc.h"
+
+#define PIC1_CMD 0x20
+#define PIC1_DATA 0x21
+#define PIC2_CMD 0xA0
+#define PIC2_DATA 0xA1
+#define PIC_EOI 0x20
+#define PIC_READ_ISR 0x0B
+
+#define PIT_HZ 1193182
+#define PIT_CH0_PORT 0x40
+#define PIT_CMD_PORT 0x43
+
+struct irq_stats irq_stats[IRQ_LINES];
+volatile uint32_t timer_ticks = 0;
+
+static irq_handler_t irq_handlers[IRQ_LINES];
+static uint16_t irq_mask = 0xFFFF;
+uint32_t uptime_ticks = 0;
+
+static volatile int timer_work_pending = 0;
+
+static void pic_set_mask(uint16_t mask) {
+  irq_mask = mask;
+  port_outb(mask & 0xFF, PIC1_DATA);
+  port_outb(mask >> 8, PIC2_DATA);
+}
+
+static uint16_t pic_isr(void) {
+  port_outb(PIC_READ_ISR, PIC1_CMD);
+  port_outb(PIC_READ_ISR, PIC2_CMD);
+  return port_inb(PIC1_CMD) | (port_inb(PIC2_CMD) << 8);
+}
+
+// Ложные IRQ 7 и 15 не отмечены в ISR; на них EOI не посылается
+// (для 15 только ведущему, который видел каскад)
+static int irq_spurious(int irq) {
+  if ((irq == 7 || irq == 15) && !(pic_isr() & (1 << irq))) {
+    if (irq == 15) {
+      port_outb(PIC_EOI, PIC1_CMD);
+    }
+    irq_stats[irq].spurious++;
+    return 1;
+  }
+  return 0;
+}
+
+static void irq_common(struct regs *r) {
+  int irq = r->vector - IRQ_BASE;
+  uint64_t start = rdtsc();
+
+  if (irq_spurious(irq)) {
+    return;
+  }
+  irq_stats[irq].count++;
+  if (irq_handlers[irq]) {
+    irq_handlers[irq](irq);
+  }
+  if (irq >= 8) {
+    port_outb(PIC_EOI, PIC2_CMD);
+  }
+  port_outb(PIC_EOI, PIC1_CMD);
+
+  uint64_t cycles = rdtsc() - start;
+  if (cycles > irq_stats[irq].max_cycles) {
+    irq_stats[irq].max_cycles = cycles;
+  }
+
+  // Выход из прерывания: отложенная работа с включёнными прерываниями
+  if (softirq_pending()) {
+    __asm__ volatile("sti");
+    softirq_run();
+    __asm__ volatile("cli");
+  }
+}
+
+void irq_install(int irq, irq_handler_t handler) {
+  irq_handlers[irq] = handler;
+  uint16_t mask = irq_mask & ~(1 << irq);
+  if (irq >= 8) {
+    mask &= ~(1 << IRQ_CASCADE);
+  }
+  pic_set_mask(mask);
+}
+
+static void timer_irq(int irq) {
+  timer_ticks++;
+  // Флаг ставится, только если элемент попал в очередь: при полной
+  // очереди попробуем снова на следующем тике
+  if (!timer_work_pending && work_queue(WORK_TIMER, 0) == 0) {
+    timer_work_pending = 1;
+  }
+}
+
+// Учёт тиков, накопившихся с прошлого запуска (запросы сливаются, поэтому
+// аргумент не нужен: берётся текущее timer_ticks)
+static void timer_work(uint32_t unused) {
+  timer_work_pending = 0;
+  uptime_ticks = timer_ticks;
+}
+
+void irq_init(void) {
+  // ICW1-ICW4: каскад, векторы 0x20/0x28, ведомый на линии 2, режим 8086
+  port_outb(0x11, PIC1_CMD);
+  port_outb(0x11, PIC2_CMD);
+  port_outb(IRQ_BASE, PIC1_DATA);
+  port_outb(IRQ_BASE + 8, PIC2_DATA);
+  port_outb(1 << IRQ_CASCADE, PIC1_DATA);
+  port_outb(IRQ_CASCADE, PIC2_DATA);
+  port_outb(0x01, PIC1_DATA);
+  port_outb(0x01, PIC2_DATA);
+  pic_set_mask(0xFFFF);
+
+  for (int i = 0; i < IRQ_LINES; i++) {
+    idt_set_handler(IRQ_BASE + i, irq_common);
+  }
+
+  uint32_t divisor = PIT_HZ / TIMER_HZ;
+  port_outb(0x36, PIT_CMD_PORT); // канал 0, lo/hi, режим 3
+  port_outb(divisor & 0xFF, PIT_CH0_PORT);
+  port_outb(divisor >> 8, PIT_CH0_PORT);
+  softirq_register(WORK_TIMER, "timer", timer_work);
+  irq_install(IRQ_TIMER, timer_irq);
+}
@@ -0,0 +1,53 @@
+#ifndef KERNEL_IRQ_H
+#define KERNEL_IRQ_H
+
+// Аппаратные прерывания: PIC 8259 перенастроен на векторы 0x20-0x2F,
+// таймер PIT (канал 0) на TIMER_HZ. Обработчик линии работает с
+// выключенными прерываниями и должен быть коротким: всё остальное он
+// откладывает через work_queue (softirq.h).
+
+#include "types.h"
+
+#define IRQ_BASE 0x20
+#define IRQ_LINES 16
+
+#define IRQ_TIMER 0
+#define IRQ_KEYBOARD 1
+#define IRQ_CASCADE 2
+#define IRQ_ATA_PRIMARY 14
+#define IRQ_ATA_SECONDARY 15
+
+#define TIMER_HZ 100
+
+typedef void (*irq_handler_t)(int irq);
+
+struct irq_stats {
+  uint32_t count;
+  uint32_t spurious;
+  uint64_t max_cycles; // самое долгое время в обработчике (прерывания выкл.)
+};
+
+extern struct irq_stats irq_stats[IRQ_LINES];
+extern volatile uint32_t timer_ticks;
+extern uint32_t uptime_ticks; // обновляет отложенная работа таймера
+
+void irq_init(void);
+void irq_install(int irq, irq_handler_t handler);
+
+static inline uint32_t irq_save(void) {
+  uint32_t flags;
+  __asm__ volatile("pushfl; popl %0; cli" : "=r"(flags) : : "memory");
+  return flags;
+}
+
+static inline void irq_restore(uint32_t flags) {
+  __asm__ volatile("pushl %0; popfl" : : "r"(flags) : "memory", "cc");
+}
+
+static inline int irqs_enabled(void) {
+  uint32_t flags;
+  __asm__ volatile("pushfl; popl %0" : "=r"(flags));
+  return (flags & 0x200) != 0;
+}
+
+#endif
@@ -1,4 +1,22 @@
+#include "kernel.h"
+#include "ata.h"
+#include "blkdev.h"
+#include "bootlog.h"
+#include "compress.h"
+#include "fbcon.h"
+#include "gdt.h"
+#include "idt.h"
+#include "irq.h"
+#include "multiboot.h"
+#include "paging.h"
+#include "pipeline.h"
+#include "process.h"
+#include "serial.h"
+#include "softirq.h"
+#include "stream.h"
+#include "tsc.h"
 #include "types.h"
+#include "fs.h"
 
 #define STATUS_REGISTER 0x64
 #define DATA_PORT 0x60
@@ -15,35 +33,6 @@
 #define VGA_COLOR_GREEN 0x2
 #define MAX_FILES 3
 #define MAX_FILENAME 32
-#define BLOCK_SIZE 512
-#define SECTOR_SIZE 512
-
-#define ATA_PORT_DATA 0x1F0
-#define ATA_PORT_ERROR 0x1F1
-#define ATA_PORT_FEATURES 0x1F1
-#define ATA_PORT_SECTOR_COUNT 0x1F2
-#define ATA_PORT_LBA_LOW 0x1F3
-#define ATA_PORT_LBA_MID 0x1F4
-#define ATA_PORT_LBA_HIGH 0x1F5
-#define ATA_PORT_DEVICE 0x1F6
-#define ATA_PORT_COMMAND 0x1F7
-#define ATA_PORT_STATUS 0x1F7
-
-#define ATA_STATUS_BUSY 0x80
-#define ATA_STATUS_DRQ 0x08
-#define ATA_STATUS_ERR 0x01
-
-// Для диска ~1MB (2048 блоков по 512 байт)
-#define TOTAL_BLOCKS 2048
-#define BLOCK_SIZE 512
-#define BITMAP_SIZE ((TOTAL_BLOCKS + 7) / 8) // = 256 байт
-#define BITMAP_BLOCKS 1 // 256 байт умещается в 1 блок 512 байт
-
-// Расположение на диске:
-#define SUPERBLOCK_LBA 0   // Суперблок
-#define BITMAP_LBA 1       // Битовая карта (1 блок)
-#define INODE_TABLE_LBA 2  // Таблица файлов (начинается с блока 2)
-#define DATA_REGION_LBA 10 // Данные файлов (начинаются с блока 10)
 
 // VGA DRIVER INIT
 char *vidmem = (char *)VGA_ADDRESS;
@@ -51,6 +40,8 @@ uint8_t terminal_color = 0x07;
 
 int cursor_x = 0;
 int cursor_y = 0;
+int console_cols = VGA_WIDTH;
+int console_rows = VGA_HEIGHT;
 
 // Assembler functions
 static inline unsigned char inb(unsigned short port) {
@@ -76,119 +67,8 @@ static inline void outw(uint16_t port, uint16_t val) {
 // basic fucntions templates
 void print_string(char *);
 void print_char(char);
-
-// hard drive basic functions (ATA functions)
-void ata_wait_busy() {
-  int timeout = 100000;
-  while (timeout-- > 0) {
-    if ((inb(ATA_PORT_STATUS) & ATA_STATUS_BUSY) == 0) {
-      return;
-    }
-  }
-  print_string("ATA timeout waiting for BUSY clear\n");
-}
-
-void ata_wait_drq() {
-  int timeout = 100000;
-  while (timeout-- > 0) {
-    if ((inb(ATA_PORT_STATUS) & ATA_STATUS_DRQ) != 0) {
-      return;
-    }
-  }
-}
-
-int ata_init() {
-
-  outb(ATA_PORT_DEVICE, 0xA0);
-
-  ata_wait_busy();
-
-  outb(ATA_PORT_COMMAND, 0xEC);
-
-  ata_wait_busy();
-
-  uint8_t status = inb(ATA_PORT_STATUS);
-  if (status == 0x00) {
-    print_string("ATA: device not found\n");
-    return -1;
-  }
-  if (status & ATA_STATUS_ERR) {
-    print_string("ATA: Error after IDENTIFY\n");
-    uint8_t error = inb(ATA_PORT_ERROR);
-    return -1;
-  }
-  ata_wait_drq();
-
-  print_string("ATA initialized successfully\n");
-  return 0;
-}
-
-void ata_read(uint32_t lba, uint8_t *buffer, uint32_t sector_count) {
-  ata_wait_busy();
-
-  outb(ATA_PORT_DEVICE, 0xE0 | ((lba >> 24) & 0x0F));
-  outb(ATA_PORT_SECTOR_COUNT, sector_count);
-  outb(ATA_PORT_LBA_LOW, lba & 0xFF);
-  outb(ATA_PORT_LBA_MID, (lba >> 8) & 0xFF);
-  outb(ATA_PORT_LBA_HIGH, (lba >> 16) & 0xFF);
-
-  outb(ATA_PORT_COMMAND, 0x20);
-
-  for (uint32_t i = 0; i < sector_count; i++) {
-    ata_wait_busy();
-    ata_wait_drq();
-    uint16_t *ptr = (uint16_t *)buffer;
-    for (int j = 0; j < 256; j++) {
-      *ptr++ = inw(ATA_PORT_DATA);
-    }
-    buffer += 512;
-  }
-}
-
-void ata_write(uint32_t lba, uint8_t *buffer, uint32_t sector_count) {
-  ata_wait_busy();
-
-  outb(ATA_PORT_SECTOR_COUNT, sector_count);
-  outb(ATA_PORT_LBA_LOW, lba & 0xFF);
-  outb(ATA_PORT_LBA_MID, (lba >> 8) & 0xFF);
-  outb(ATA_PORT_LBA_HIGH, (lba >> 16) & 0xFF);
-  outb(ATA_PORT_DEVICE, 0xE0 | ((lba >> 24) & 0x0F));
-
-  for (uint32_t i = 0; i < sector_count; i++) {
-
-    ata_wait_busy();
-    ata_wait_drq();
-    const uint16_t *ptr = (const uint16_t *)buffer;
-    for (int j = 0; j < 256; j++) {
-      outw(ATA_PORT_DATA, *ptr++);
-    }
-    buffer += SECTOR_SIZE;
-  }
-}
-
-void ata_test() {
-  print_string("Testing ATA...\n");
-  if (ata_init() != 0) {
-    print_string("ATA init failed\n");
-    return;
-  }
-  uint8_t buffer[512];
-  print_string("reading sector 0...\n");
-
-  ata_read(0, buffer, 1);
-  print_string("First 16 bytes:");
-  for (int i = 0; i < 16; i++) {
-    char hex[3];
-    uint8_t val = buffer[i];
-    uint8_t high = (val >> 4) & 0xF;
-    uint8_t low = val & 0xF;
-
-    print_char(high < 10 ? '0' + high : 'A' + high - 10);
-    print_char(low < 10 ? '0' + low : 'A' + low - 10);
-    print_char(' ');
-  }
-  print_char('\n');
-}
+void print_uint(uint32_t);
+void print_hex(uint32_t);
 
 // basic functions
 
@@ -300,6 +180,21 @@ int fs_write_file(char *name, char *content) {
   return -1;
 }
 
+// Дописать в конец файла; возвращает сколько байт поместилось
+uint32_t fs_append_file(char *name, char *data, uint32_t len) {
+  int index = fs_find_file(name);
+  if (index == -1)
+    index = fs_create_file(name);
+  if (index < 0)
+    return 0;
+  uint32_t room = BLOCK_SIZE - filesystem[index].size;
+  if (len > room)
+    len = room;
+  mem_cpy(filesystem[index].data + filesystem[index].size, data, len);
+  filesystem[index].size += len;
+  return len;
+}
+
 char *fs_read_file(char *name) {
   int index = fs_find_file(name);
   if (index != -1) {
@@ -400,7 +295,17 @@ void set_terminal_color(uint8_t fg, uint8_t bg) {
   terminal_color = (bg << 4) | (fg & 0x0F);
 }
 
+// Пока идёт пакетное выполнение (source), курсор не двигается на каждый символ
+int console_batch = 0;
+
 void update_cursor() {
+  if (console_batch) {
+    return;
+  }
+  if (fbcon_active) {
+    fbcon_cursor(cursor_x, cursor_y);
+    return;
+  }
   uint16_t pos = cursor_y * VGA_WIDTH + cursor_x;
 
   outb(0x3D4, 0x0F);
@@ -409,19 +314,25 @@ void update_cursor() {
   outb(0x3D5, (uint8_t)((pos >> 8) & 0xFF));
 }
 
+// Ячейка экрана; консоль на кадровом буфере сразу рисует её
+static void put_cell(int x, int y, char c) {
+  int pos = y * console_cols + x;
+  vidmem[pos * 2] = c;
+  vidmem[pos * 2 + 1] = terminal_color;
+  if (fbcon_active) {
+    fbcon_draw_cell(pos);
+  }
+}
+
 void DeleteChar() {
 
   if (cursor_x > 0) {
     cursor_x--;
-    int offset = (cursor_y * VGA_WIDTH + cursor_x) * 2;
-    vidmem[offset] = ' ';
-    vidmem[offset + 1] = terminal_color;
+    put_cell(cursor_x, cursor_y, ' ');
   } else if (cursor_y > 0) {
     cursor_y--;
-    cursor_x = VGA_WIDTH - 1;
-    int offset = (cursor_y * VGA_WIDTH + cursor_x) * 2;
-    vidmem[offset] = ' ';
-    vidmem[offset + 1] = terminal_color;
+    cursor_x = console_cols - 1;
+    put_cell(cursor_x, cursor_y, ' ');
   }
 }
 
@@ -439,20 +350,21 @@ void print_char(char c) {
     update_cursor();
 
   } else {
-    if (cursor_x > VGA_WIDTH) {
+    if (cursor_x >= console_cols) {
       cursor_x = 0;
       cursor_y++;
-      update_cursor();
+      if (cursor_y >= console_rows) {
+        scroll_screen();
+        cursor_y = console_rows - 1;
+      }
     }
-    int offset = (cursor_y * VGA_WIDTH + cursor_x) * 2;
-    vidmem[offset] = c;
-    vidmem[offset + 1] = terminal_color;
+    put_cell(cursor_x, cursor_y, c);
     cursor_x++;
     update_cursor();
   }
-  if (cursor_y >= VGA_HEIGHT) {
+  if (cursor_y >= console_rows) {
     scroll_screen();
-    cursor_y = VGA_HEIGHT - 1;
+    cursor_y = console_rows - 1;
   }
 }
 void print_string(char *str) {
@@ -461,119 +373,222 @@ void print_string(char *str) {
   }
 }
 
+void print_uint(uint32_t value) {
+  char buf[11];
+  int i = 10;
+  buf[i] = '\0';
+  do {
+    buf[--i] = '0' + value % 10;
+    value /= 10;
+  } while (value);
+  print_string(&buf[i]);
+}
+
+void print_hex(uint32_t value) {
+  print_string("0x");
+  for (int shift = 28; shift >= 0; shift -= 4) {
+    uint8_t digit = (value >> shift) & 0xF;
+    print_char(digit < 10 ? '0' + digit : 'A' + digit - 10);
+  }
+}
+
 void clean_screen() {
   unsigned int i = 0, j = 0;
 
-  while (j < VGA_WIDTH * VGA_HEIGHT * 2) {
+  while (j < console_cols * console_rows * 2) {
     vidmem[j] = ' ';
     vidmem[j + 1] = 0x07;
     j += 2;
   }
   cursor_x = 0;
   cursor_y = 0;
+  if (fbcon_active) {
+    fbcon_sync();
+    fbcon_cursor(0, 0);
+  }
 }
 
 void scroll_screen() {
 
-  for (int y = 1; y < VGA_HEIGHT; y++) {
-    for (int x = 0; x < VGA_WIDTH; x++) {
-      int offset_from = (y * VGA_WIDTH + x) * 2;
-      int offset_to = ((y - 1) * VGA_WIDTH + x) * 2;
+  for (int y = 1; y < console_rows; y++) {
+    for (int x = 0; x < console_cols; x++) {
+      int offset_from = (y * console_cols + x) * 2;
+      int offset_to = ((y - 1) * console_cols + x) * 2;
       vidmem[offset_to] = vidmem[offset_from];
       vidmem[offset_to + 1] = vidmem[offset_from + 1];
     }
   }
-  int last_row_start = (VGA_HEIGHT - 1) * VGA_WIDTH * 2;
-  for (int x = 0; x < VGA_WIDTH; x++) {
+  int last_row_start = (console_rows - 1) * console_cols * 2;
+  for (int x = 0; x < console_cols; x++) {
     vidmem[last_row_start + x * 2] = ' ';
     vidmem[last_row_start + x * 2 + 1] = terminal_color;
   }
+  // Буфер ячеек в памяти; на экран идут только изменившиеся строки
+  if (fbcon_active) {
+    fbcon_sync();
+  }
 
-  if (cursor_y == VGA_HEIGHT) {
-    cursor_y = VGA_HEIGHT - 1;
+  if (cursor_y == console_rows) {
+    cursor_y = console_rows - 1;
     cursor_x = 0;
     update_cursor();
   }
 }
 
-// hard drive FS struct
-#define INODES_PER_BLOCK 8 // Сколько DiskFileEntry помещается в блок
-
-// Суперблок нужно расширить
-struct SuperBlock {
-  uint32_t magic;
-  uint32_t total_blocks;
-  uint32_t free_blocks;
-  uint32_t bitmap_start;
-  uint32_t inode_start;
-  uint32_t data_start;
-  uint32_t inode_count;
-  uint32_t free_inodes;
-};
+// hard drive driver functions
+struct FileSystem hd_fs;
+uint32_t hd_inode_count = 0;
+uint32_t hd_inode_limit = 0; // дальше этого номера занятых inode нет
+int hd_mounted = 0;
+
+// Таблица inode читается страницами по INODES_PER_PAGE при первом
+// обращении: монтирование не зависит от размера диска
+#define INODES_PER_PAGE (PAGE_SIZE / sizeof(struct DiskFileEntry))
+#define INODE_PAGE_BLOCKS (PAGE_SIZE / BLOCK_SIZE)
+#define INODE_PAGES_MAX 8192
+#define INODE_POOL_PAGES 8 // без страничной памяти
+
+static struct DiskFileEntry *inode_pages[INODE_PAGES_MAX];
+static uint8_t inode_pool[INODE_POOL_PAGES][PAGE_SIZE];
+static uint32_t inode_pool_used = 0;
+uint32_t inode_pages_loaded = 0;
+
+static void *inode_page_alloc(void) {
+  if (paging_enabled) {
+    uint32_t phys = frame_alloc();
+    return phys ? phys_to_virt(phys) : NULL;
+  }
+  if (inode_pool_used < INODE_POOL_PAGES) {
+    return inode_pool[inode_pool_used++];
+  }
+  return NULL;
+}
 
-struct DiskFileEntry {
-  char name[256];
-  uint32_t size;
-  uint32_t start_block;
-  uint32_t blocks_count;
-  uint8_t is_used;
-};
+// Если памяти под страницу нет, она читается во временный буфер:
+// указатель действителен до следующего вызова fs_inode
+struct DiskFileEntry *fs_inode(struct FileSystem *fs, uint32_t ino) {
+  static uint8_t scratch[PAGE_SIZE];
+  static uint32_t scratch_page = (uint32_t)-1;
+  uint32_t page = ino / INODES_PER_PAGE;
+
+  struct DiskFileEntry *table = inode_pages[page];
+  if (!table) {
+    if (page == scratch_page) {
+      table = (struct DiskFileEntry *)scratch;
+    } else {
+      void *buf = inode_page_alloc();
+      uint32_t first = fs->superblock.inode_start + page * INODE_PAGE_BLOCKS;
+      uint32_t blocks = (hd_inode_count - page * INODES_PER_PAGE +
+                         INODES_PER_BLOCK - 1) / INODES_PER_BLOCK;
+      if (blocks > INODE_PAGE_BLOCKS) {
+        blocks = INODE_PAGE_BLOCKS;
+      }
+      ata_read_blocks(first, buf ? buf : scratch, blocks);
+      if (buf) {
+        inode_pages[page] = table = buf;
+        inode_pages_loaded++;
+      } else {
+        scratch_page = page;
+        table = (struct DiskFileEntry *)scratch;
+      }
+    }
+  }
+  return &table[ino % INODES_PER_PAGE];
+}
 
-struct FileSystem {
-  struct SuperBlock superblock;
-  uint8_t block_bitmap[BITMAP_SIZE];
-  struct DiskFileEntry *inodes;
-};
+// Свободные блоки по битовой карте, если сводке групп верить нельзя
+static uint32_t fs_count_free(struct FileSystem *fs, uint32_t first_group,
+                              uint32_t groups) {
+  uint8_t block[BLOCK_SIZE];
+  uint32_t total = fs->superblock.total_blocks;
+  uint32_t free = 0;
+
+  for (uint32_t g = first_group; g < first_group + groups; g++) {
+    ata_read(fs->superblock.bitmap_start + g, block, 1);
+    uint32_t base = g * BLOCKS_PER_GROUP;
+    for (uint32_t bit = 0; bit < BLOCKS_PER_GROUP && base + bit < total;
+         bit++) {
+      if (!(block[bit / 8] & (1 << (bit % 8)))) {
+        free++;
+      }
+    }
+  }
+  return free;
+}
 
-// void fs_init_hd(struct FileSystem *fs, uint32_t total_blocks) {}
+// Монтирование образа, созданного tools/mkkeprfs (только чтение).
+// Читается только суперблок; после некорректного размонтирования
+// счётчики свободного места пересчитываются по битовой карте и таблице
+int fs_mount_hd(struct FileSystem *fs) {
+  uint8_t block[BLOCK_SIZE];
 
-int allocate_block(struct FileSystem *fs) {
-  for (uint32_t byte_idx = 0; byte_idx < BITMAP_SIZE; byte_idx++) {
-    uint8_t current_byte = fs->block_bitmap[byte_idx];
-    if (current_byte != 0xFF) {
-      for (int bit_idx = 0; bit_idx < 8; bit_idx++) {
-        uint8_t mask = 1 << byte_idx;
+  ata_read(SUPERBLOCK_LBA, block, 1);
+  mem_cpy(&fs->superblock, block, sizeof(struct SuperBlock));
+  struct SuperBlock *sb = &fs->superblock;
+  if (sb->magic != FS_MAGIC) {
+    return -1;
+  }
 
-        if ((current_byte & mask) == 0) {
-          fs->block_bitmap[byte_idx] = mask;
-          uint32_t block_num = (byte_idx * 8) + bit_idx;
-          return block_num;
-        }
+  hd_inode_count = sb->inode_count;
+  if (hd_inode_count > INODE_PAGES_MAX * INODES_PER_PAGE) {
+    hd_inode_count = INODE_PAGES_MAX * INODES_PER_PAGE;
+  }
+  hd_inode_limit = hd_inode_count;
+  if (sb->state != FS_STATE_CLEAN) {
+    uint32_t groups =
+        (sb->total_blocks + BLOCKS_PER_GROUP - 1) / BLOCKS_PER_GROUP;
+    sb->free_blocks = fs_count_free(fs, 0, groups);
+    sb->free_inodes = 0;
+    for (uint32_t i = 0; i < hd_inode_count; i++) {
+      if (!fs_inode(fs, i)->is_used) {
+        sb->free_inodes++;
       }
     }
+    sb->features &= ~FS_FEATURE_SORTED;
+  } else if ((sb->features & FS_FEATURE_SORTED) &&
+             sb->inode_count - sb->free_inodes < hd_inode_count) {
+    hd_inode_limit = sb->inode_count - sb->free_inodes;
   }
-  return -1;
+  return 0;
 }
 
-void free_block(struct FileSystem *fs, uint32_t block_num) {
-  if (block_num >= (BITMAP_SIZE * 8)) {
-    print_string("ошибка: номер блока за пределами диска");
-    return;
+int fs_find_hd(struct FileSystem *fs, char *name) {
+  if (fs->superblock.features & FS_FEATURE_SORTED) {
+    uint32_t lo = 0, hi = hd_inode_limit;
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      int cmp = strcmp(name, fs_inode(fs, mid)->name);
+      if (cmp == 0) {
+        return mid;
+      }
+      if (cmp < 0) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    return -1;
   }
-  uint32_t byte_idx = block_num / 8;
-  uint32_t bit_ind = block_num % 8;
-  uint8_t mask = 1 << bit_ind;
-
-  fs->block_bitmap[byte_idx] &= ~mask;
+  for (uint32_t i = 0; i < hd_inode_limit; i++) {
+    struct DiskFileEntry *entry = fs_inode(fs, i);
+    if (entry->is_used && !strcmp(entry->name, name)) {
+      return i;
+    }
+  }
+  return -1;
 }
 
-// hard drive driver functions
-
 // console/terminal/shell
 
-typedef void (*command_handler_t)(int argc, char **argv);
-
-typedef struct {
-  const char *name;
-  const char *description;
-  command_handler_t handler;
-} command_t;
+#define MAX_COMMANDS 64
+#define MAX_SOURCE_DEPTH 4
+#define SCRIPT_LINE_MAX 256
 
 int tokinaze(char *str, char **argv) {
   int argc = 0;
   int is_quote = 0;
 
-  while (*str) {
+  while (*str && argc < SHELL_MAX_ARGS - 1) {
     while (*str == ' ') {
       *str++ = '\0';
     }
@@ -615,7 +630,9 @@ void cmd_cat(int argc, char **argv);
 void cmd_write(int argc, char **argv);
 void cmd_touch(int argc, char **argv);
 void cmd_ls(int argc, char **argv);
+void cmd_df(int argc, char **argv);
 void cmd_rm(int argc, char **argv);
+void cmd_source(int argc, char **argv);
 
 command_t cmd_table[] = {{"help", "show all commands", cmd_help},
                          {"clear", "clear screen", cmd_clear},
@@ -624,22 +641,79 @@ command_t cmd_table[] = {{"help", "show all commands", cmd_help},
                          {"write", "write data in file", cmd_write},
                          {"touch", "creating new file", cmd_touch},
                          {"ls", "list all files", cmd_ls},
+                         {"df", "disk free space by group", cmd_df},
                          {"rm", "remove(delete) file", cmd_rm},
+                         {"mem", "memory and page cache stats", cmd_mem},
+                         {"mscan", "scan disk file: read vs mmap", cmd_mscan},
+                         {"source", "run commands from a file", cmd_source},
+                         {"lsblk", "list block devices", cmd_lsblk},
+                         {"raid", "stripe disks into a raid0 array", cmd_raid},
+                         {"blkbench", "sequential read benchmark", cmd_blkbench},
+                         {"zbench", "disk file read: plain vs compressed", cmd_zbench},
+                         {"irqstat", "interrupt and deferred work stats", cmd_irqstat},
+                         {"bootlog", "boot phase timings", cmd_bootlog},
+                         {"fbbench", "console output and redraw speed", cmd_fbbench},
                          {NULL, NULL, NULL}};
 
+// Реестр команд: отсортирован по имени при регистрации, поиск двоичный
+command_t *commands[MAX_COMMANDS];
+int command_count = 0;
+
+int register_command(command_t *cmd) {
+  if (command_count == MAX_COMMANDS) {
+    return -1;
+  }
+  int i = command_count;
+  while (i > 0 && strcmp(commands[i - 1]->name, cmd->name) > 0) {
+    commands[i] = commands[i - 1];
+    i--;
+  }
+  commands[i] = cmd;
+  command_count++;
+  return 0;
+}
+
+command_t *find_command(const char *name) {
+  int lo = 0, hi = command_count - 1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    int cmp = strcmp(name, commands[mid]->name);
+    if (cmp == 0) {
+      return commands[mid];
+    }
+    if (cmp < 0) {
+      hi = mid - 1;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return NULL;
+}
+
+void shell_init() {
+  for (int i = 0; cmd_table[i].name != NULL; i++) {
+    register_command(&cmd_table[i]);
+  }
+}
+
 // cmd functions full
 
 void cmd_echo(int argc, char **argv) {
   for (int i = 1; i < argc; i++) {
-    print_string(argv[i]);
-    print_string(" ");
-    print_char('\n');
+    sh_print(argv[i]);
+    sh_print(" ");
+    sh_putc('\n');
   }
 }
 
 void cmd_help(int argc, char **argv) {
-  char *help_str = "Available commands: echo,help,clear\n";
-  print_string(help_str);
+  sh_print("Available commands:\n");
+  for (int i = 0; i < command_count; i++) {
+    sh_print((char *)commands[i]->name);
+    sh_print(" - ");
+    sh_print((char *)commands[i]->description);
+    sh_putc('\n');
+  }
 }
 
 void cmd_write(int argc, char **argv) {
@@ -659,11 +733,55 @@ void cmd_write(int argc, char **argv) {
   }
 }
 
+// С включённой страничной памятью страницы page cache уходят в поток по
+// ссылке: "cat file | grep x" не копирует данные файла
+void cat_hd_file(int inode) {
+  struct DiskFileEntry *entry = fs_inode(&hd_fs, inode);
+  uint32_t left = entry->size;
+
+  if (paging_enabled) {
+    for (uint32_t index = 0; left > 0; index++) {
+      uint32_t page = page_cache_get(inode, index);
+      if (!page) {
+        print_string("error: out of memory\n");
+        return;
+      }
+      uint32_t n = left > PAGE_SIZE ? PAGE_SIZE : left;
+      sh_write(phys_to_virt(page), n);
+      page_cache_put(inode, index);
+      left -= n;
+    }
+    return;
+  }
+
+  static uint8_t chunk[FS_CHUNK_SIZE];
+  for (uint32_t index = 0; left > 0; index++) {
+    fs_read_chunk(entry, index, chunk);
+    uint32_t n = left > FS_CHUNK_SIZE ? FS_CHUNK_SIZE : left;
+    sh_write((char *)chunk, n);
+    left -= n;
+  }
+}
+
 void cmd_cat(int argc, char **argv) {
-  char *date = fs_read_file(argv[1]);
-  print_char('\n');
-  print_string(date);
-  print_char('\n');
+  if (argc < 2) {
+    print_string("need file name(cat <filename>)\n");
+    return;
+  }
+  // Ошибка - только на экран, в поток конвейера идёт лишь файл
+  int index = fs_find_file(argv[1]);
+  int inode = index == -1 && hd_mounted ? fs_find_hd(&hd_fs, argv[1]) : -1;
+  if (index == -1 && inode == -1) {
+    print_string("\nerror: file not exist\n");
+    return;
+  }
+  sh_putc('\n');
+  if (index != -1) {
+    sh_write(filesystem[index].data, filesystem[index].size);
+  } else {
+    cat_hd_file(inode);
+  }
+  sh_putc('\n');
 }
 
 void cmd_touch(int argc, char **argv) {
@@ -700,63 +818,319 @@ void cmd_ls(int argc, char **argv) {
 
   for (int i = 0; i < MAX_FILES; i++) {
     if (names[i][0] != '\0') {
-      print_string(names[i]);
-      print_char('\n');
+      sh_print(names[i]);
+      sh_putc('\n');
+    }
+  }
+  if (!hd_mounted) {
+    return;
+  }
+  for (uint32_t i = 0; i < hd_inode_limit; i++) {
+    struct DiskFileEntry *entry = fs_inode(&hd_fs, i);
+    if (entry->is_used) {
+      sh_print(entry->name);
+      sh_putc(' ');
+      sh_print_uint(entry->size);
+      if (entry->flags & FS_FILE_COMPRESSED) {
+        uint32_t ratio = fs_ratio10(entry);
+        sh_print(" lz ");
+        sh_print_uint(ratio / 10);
+        sh_putc('.');
+        sh_print_uint(ratio % 10);
+        sh_putc('x');
+      }
+      sh_putc('\n');
     }
   }
 }
 
+// Свободное место диска: счётчики из суперблока и сводка групп
+void cmd_df(int argc, char **argv) {
+  if (!hd_mounted) {
+    print_string("error: disk FS not mounted\n");
+    return;
+  }
+  struct SuperBlock *sb = &hd_fs.superblock;
+  sh_print("blocks ");
+  sh_print_uint(sb->total_blocks - sb->free_blocks);
+  sh_putc('/');
+  sh_print_uint(sb->total_blocks);
+  sh_print(" used, inodes ");
+  sh_print_uint(sb->inode_count - sb->free_inodes);
+  sh_putc('/');
+  sh_print_uint(sb->inode_count);
+  sh_print(" used, ");
+  sh_print(sb->state == FS_STATE_CLEAN ? "clean" : "recounted");
+  sh_print(", inode pages loaded ");
+  sh_print_uint(inode_pages_loaded);
+  sh_putc('\n');
+
+  // Сводку групп используем, только если ФС размонтирована корректно
+  int summary = sb->state == FS_STATE_CLEAN && sb->summary_start;
+  uint32_t groups =
+      (sb->total_blocks + BLOCKS_PER_GROUP - 1) / BLOCKS_PER_GROUP;
+  uint32_t full = 0, empty = 0;
+  uint32_t block[GROUP_ENTRIES_PER_BLOCK];
+  for (uint32_t g = 0; g < groups; g++) {
+    uint32_t free;
+    if (summary) {
+      if (g % GROUP_ENTRIES_PER_BLOCK == 0) {
+        ata_read(sb->summary_start + g / GROUP_ENTRIES_PER_BLOCK,
+                 (uint8_t *)block, 1);
+      }
+      free = block[g % GROUP_ENTRIES_PER_BLOCK];
+    } else {
+      free = fs_count_free(&hd_fs, g, 1);
+    }
+    uint32_t size = sb->total_blocks - g * BLOCKS_PER_GROUP;
+    if (size > BLOCKS_PER_GROUP) {
+      size = BLOCKS_PER_GROUP;
+    }
+    full += free == 0;
+    empty += free == size;
+    if (groups <= 16) {
+      sh_print("group ");
+      sh_print_uint(g);
+      sh_print(": ");
+      sh_print_uint(free);
+      sh_print(" free\n");
+    }
+  }
+  sh_print("groups ");
+  sh_print_uint(groups);
+  sh_print(", full ");
+  sh_print_uint(full);
+  sh_print(", empty ");
+  sh_print_uint(empty);
+  sh_putc('\n');
+}
+
 // parser
+void shell_run(int argc, char **argv) {
+  command_t *cmd = find_command(argv[0]);
+  if (cmd) {
+    cmd->handler(argc, argv);
+    return;
+  }
+  if (process_exec(argc, argv) != EXEC_NOT_FOUND) {
+    return;
+  }
+  print_string("error:unknow command: ");
+  print_string(argv[0]);
+  print_string("\nUse 'help' for view command list\n");
+}
+
 void shell_execute(char *input) {
-  char *argv[16];
+  if (pipeline_needed(input)) {
+    pipeline_execute(input);
+    return;
+  }
+  char *argv[SHELL_MAX_ARGS];
   int argc = tokinaze(input, argv);
   if (argc == 0)
     return;
+  shell_run(argc, argv);
+}
 
-  for (int i = 0; cmd_table[i].name != NULL; i++) {
-    if (strcmp(argv[0], cmd_table[i].name) == 0) {
-      cmd_table[i].handler(argc, argv);
-      return;
+int source_depth = 0;
+
+// Скрипт подаётся кусками (файл с диска без mmap читается по
+// FS_CHUNK_SIZE), поэтому строка собирается между вызовами script_feed
+struct script_reader {
+  char line[SCRIPT_LINE_MAX];
+  uint32_t len;
+  uint32_t line_no;
+  int too_long;
+  int executed;
+};
+
+// Пустые строки и строки с '#' пропускаются; обрезанную строку
+// выполнять нельзя - она сообщается и пропускается
+static void script_line(struct script_reader *r) {
+  r->line_no++;
+  r->line[r->len] = '\0';
+  if (r->too_long) {
+    print_string("error: line ");
+    print_uint(r->line_no);
+    print_string(" is longer than ");
+    print_uint(SCRIPT_LINE_MAX - 1);
+    print_string(" chars, skipped\n");
+  } else {
+    char *p = r->line;
+    while (*p == ' ') {
+      p++;
+    }
+    if (*p != '\0' && *p != '#') {
+      shell_execute(p);
+      r->executed++;
+    }
+  }
+  r->len = 0;
+  r->too_long = 0;
+}
+
+static void script_feed(struct script_reader *r, const char *data,
+                        uint32_t size) {
+  for (uint32_t pos = 0; pos < size; pos++) {
+    char c = data[pos];
+    if (c == '\n') {
+      script_line(r);
+    } else if (c == '\r') {
+      continue;
+    } else if (r->len < SCRIPT_LINE_MAX - 1) {
+      r->line[r->len++] = c;
+    } else {
+      r->too_long = 1;
     }
   }
-  print_string("error:unknow command: ");
-  print_string(argv[0]);
-  print_string("\nUse 'help' for view command list\n");
 }
 
+// Без страничной памяти (или если mmap не удался) файл читается по
+// кускам; у каждого уровня вложенного source свой буфер
+static int source_hd_chunks(struct script_reader *r, int inode) {
+  static uint8_t chunks[MAX_SOURCE_DEPTH][FS_CHUNK_SIZE];
+  uint8_t *chunk = chunks[source_depth - 1];
+  uint32_t left = fs_inode(&hd_fs, inode)->size;
+
+  for (uint32_t index = 0; left > 0; index++) {
+    if (fs_read_chunk(fs_inode(&hd_fs, inode), index, chunk) != 0) {
+      return -1;
+    }
+    uint32_t n = left > FS_CHUNK_SIZE ? FS_CHUNK_SIZE : left;
+    script_feed(r, (char *)chunk, n);
+    left -= n;
+  }
+  return 0;
+}
+
+void cmd_source(int argc, char **argv) {
+  if (argc < 2) {
+    print_string("need file name(source <filename>)\n");
+    return;
+  }
+  if (source_depth == MAX_SOURCE_DEPTH) {
+    print_string("error: source nested too deep\n");
+    return;
+  }
+
+  char *data = NULL;
+  uint32_t size = 0;
+  int inode = -1;
+  int index = fs_find_file(argv[1]);
+  if (index != -1) {
+    data = filesystem[index].data;
+    size = filesystem[index].size;
+  } else if (hd_mounted) {
+    inode = fs_find_hd(&hd_fs, argv[1]);
+    if (inode != -1) {
+      data = mmap_file(argv[1], &size);
+    }
+  }
+  if (index == -1 && inode == -1) {
+    print_string("error: file not exist");
+    return;
+  }
+
+  struct script_reader reader;
+  memset(&reader, 0, sizeof(reader));
+  int rc = 0;
+  uint64_t start = rdtsc();
+  source_depth++;
+  console_batch++;
+  if (data) {
+    script_feed(&reader, data, size);
+  } else {
+    rc = source_hd_chunks(&reader, inode);
+  }
+  if (rc == 0 && (reader.len > 0 || reader.too_long)) {
+    script_line(&reader); // последняя строка без '\n'
+  }
+  console_batch--;
+  source_depth--;
+  uint32_t us = tsc_to_us(rdtsc() - start);
+  if (data && inode != -1) {
+    munmap_file(data);
+  }
+  update_cursor();
+
+  if (rc != 0) {
+    print_string("\nerror: ");
+    print_string(argv[1]);
+    print_string(": corrupt chunk, script stopped\n");
+  }
+  print_string("\nsource: ");
+  print_uint(reader.executed);
+  print_string(" commands in ");
+  print_uint(us);
+  print_string(" us\n");
+}
+
+// Клавиатура: IRQ 1 только забирает скан-код, разбор (модификаторы,
+// scancode_to_ascii) идёт отложенной работой, готовые символы копятся в
+// кольце и читаются get_char
+#define KEY_BUFFER_SIZE 64
+
+static char key_buffer[KEY_BUFFER_SIZE];
+static volatile uint32_t key_head = 0, key_tail = 0;
+
+static void keyboard_irq(int irq) {
+  work_queue(WORK_KEYBOARD, inb(DATA_PORT));
+}
+
+static void keyboard_work(uint32_t arg) {
+  uint8_t scancode = arg;
+  uint8_t key_released = scancode & 0x80;
+  switch (scancode & 0x7F) {
+  case 0x2A:
+    kdb_state.left_shift_pressed = !key_released;
+    break;
+  case 0x36:
+    kdb_state.right_shift_pressed = !key_released;
+    break;
+  case 0x1D:
+    kdb_state.ctr_pressed = !key_released;
+    break;
+  case 0x38:
+    kdb_state.alt_pressed = !key_released;
+    break;
+  case 0x3A:
+    if (!key_released) {
+      kdb_state.capslock_pressed = !kdb_state.capslock_pressed;
+      break;
+    }
+  }
+  if (!(scancode & 0x80)) {
+    char c = scancode_to_ascii(scancode);
+    if (c > 0 && key_head - key_tail < KEY_BUFFER_SIZE) {
+      key_buffer[key_head % KEY_BUFFER_SIZE] = c;
+      key_head++;
+    }
+  }
+}
+
+void keyboard_init() {
+  while (inb(STATUS_REGISTER) & 0x01) {
+    inb(DATA_PORT); // нажатия до включения прерываний
+  }
+  softirq_register(WORK_KEYBOARD, "keyboard", keyboard_work);
+  irq_install(IRQ_KEYBOARD, keyboard_irq);
+}
+
+// Ожидание символа - и есть рабочий цикл отложенной работы: здесь
+// разбирается то, что не уместилось в бюджет на выходе из прерывания
 char get_char() {
-  unsigned char scancode;
-  while (1) {
-    if (inb(STATUS_REGISTER) & 0x01) {
-      scancode = inb(DATA_PORT);
-      uint8_t key_released = scancode & 0x80;
-      switch (scancode & 0x7F) {
-      case 0x2A:
-        kdb_state.left_shift_pressed = !key_released;
-        break;
-      case 0x36:
-        kdb_state.right_shift_pressed = !key_released;
-        break;
-      case 0x1D:
-        kdb_state.ctr_pressed = !key_released;
-        break;
-      case 0x38:
-        kdb_state.alt_pressed = !key_released;
-        break;
-      case 0x3A:
-        if (!key_released) {
-          kdb_state.capslock_pressed = !kdb_state.capslock_pressed;
-          break;
-        }
-      }
-      if (!(scancode & 0x80)) {
-        char c = scancode_to_ascii(scancode);
-        if (c > 0) {
-          return c;
-        }
-      }
+  while (key_tail == key_head) {
+    softirq_run();
+    __asm__ volatile("cli");
+    if (key_tail == key_head && !softirq_pending()) {
+      __asm__ volatile("sti; hlt"); // sti откладывает IRQ до hlt
+    } else {
+      __asm__ volatile("sti");
     }
   }
+  char c = key_buffer[key_tail % KEY_BUFFER_SIZE];
+  key_tail++;
+  return c;
 }
 
 char *read_line(char *buffer, int max_len) {
@@ -789,11 +1163,58 @@ char *read_line(char *buffer, int max_len) {
   }
 }
 
-void os_main(void) {
+void os_main(uint32_t magic, struct multiboot_info *mbi) {
+  bootlog_mark("os_main");
+  // До fbcon_enable текст копится в буфере ячеек кадрового буфера
+  char *cells = fbcon_probe(magic, mbi, &console_cols, &console_rows);
+  if (cells) {
+    vidmem = cells;
+  }
   clean_screen();
   set_terminal_color(VGA_COLOR_WHITE, VGA_COLOR_BLACK);
   print_string("Hello from KeprOS!\n");
-  if (ata_init() == 0) {
+  bootlog_mark("clean_screen");
+
+  gdt_init();
+  idt_init();
+  bootlog_mark("gdt/idt");
+  tsc_init();
+  bootlog_mark("tsc calibration");
+  irq_init();
+  keyboard_init();
+  bootlog_mark("irq/keyboard");
+  uint32_t mem_kb;
+  if (magic == MULTIBOOT_BOOTLOADER_MAGIC &&
+      (mbi->flags & MULTIBOOT_INFO_MEMORY)) {
+    mem_kb = 1024 + mbi->mem_upper;
+  } else {
+    mem_kb = cmos_memory_kb();
+  }
+  if (paging_init(mem_kb) == 0) {
+    print_string("Paging enabled, ");
+    print_uint(mem_kb / 1024);
+    print_string(" MB\n");
+    process_init();
+  }
+  bootlog_mark("paging");
+  if (cells) {
+    if (fbcon_enable() == 0) {
+      print_string("Framebuffer console ");
+      print_uint(console_cols);
+      print_char('x');
+      print_uint(console_rows);
+      print_char('\n');
+    } else if (serial_ready()) {
+      // Загрузчик уже включил графику, и 0xB8000 на экран не попадёт:
+      // текст остаётся в буфере ячеек, сообщение уходит в COM1
+      serial_print("Framebuffer map failed, console kept in RAM\n");
+    }
+    bootlog_mark("framebuffer");
+  }
+
+  int ata_ok = ata_init() == 0;
+  bootlog_mark("ata probe");
+  if (ata_ok) {
     print_string("ATA OK \n");
     uint8_t sector[512];
     ata_read(0, sector, 1);
@@ -803,40 +1224,41 @@ void os_main(void) {
     } else {
       print_string("No MBR signature\n");
     }
+    bootlog_mark("mbr read");
   } else {
     print_string("ATA init failed\n");
   }
 
-  char *buffer;
+  char buffer[256];
   print_string("Initializing file system...\n");
-  struct FileSystem fs;
-
-  memset(&fs, 0, sizeof(struct FileSystem));
-  fs.superblock.total_blocks = 2048;
-  fs.superblock.free_blocks = 2000;
-
-  memset(fs.block_bitmap, 0, BITMAP_SIZE);
-
-  for (int i = 0; i < 48; i++) {
-    uint32_t byte_idx = i / 8;
-    uint32_t bit_idx = i % 8;
-    uint8_t mask = 1 << bit_idx;
-    fs.block_bitmap[byte_idx] = mask;
-    fs.superblock.free_blocks--;
+  uint64_t mount_tsc = rdtsc();
+  if (ata_ok && fs_mount_hd(&hd_fs) == 0) {
+    hd_mounted = 1;
+    print_string("Disk FS mounted, ");
+    print_uint(hd_fs.superblock.total_blocks / 2048);
+    print_string(" MB, ");
+    print_uint(tsc_to_us(rdtsc() - mount_tsc));
+    print_string(" us\n");
   }
   print_string("FS init\n");
-
-  int block = allocate_block(&fs);
-  if (block != -1) {
-    char msg[50];
-    print_string("block allocated\n");
-  }
+  bootlog_mark("fs mount");
 
   fs_init();
+  shell_init();
+  bootlog_mark("shell init");
+  print_string("Boot to prompt: ");
+  print_uint(bootlog_total_us() / 1000);
+  print_string(" ms (bootlog for phases)\n");
+
+  // Без экрана (qemu -display none -serial stdio) трасса видна в COM1
+  if (serial_ready()) {
+    bootlog_print(serial_print);
+  }
+  __asm__ volatile("sti");
 
   while (1) {
     print_string("\nroot@keprOS> ");
-    char *line = read_line(buffer, 1000000);
+    char *line = read_line(buffer, sizeof(buffer));
     shell_execute(line);
   }
 }
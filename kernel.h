@@ -0,0 +1,60 @@
+#ifndef KERNEL_KERNEL_H
+#define KERNEL_KERNEL_H
+
+// Функции kernel.c, которыми пользуются остальные модули ядра
+
+#include "fs.h"
+#include "types.h"
+
+#define SECTOR_SIZE 512
+
+// console: текстовый режим VGA или fbcon, размер в символах
+extern int console_cols;
+extern int console_rows;
+void print_string(char *str);
+void print_char(char c);
+void print_uint(uint32_t value);
+void print_hex(uint32_t value);
+void clean_screen(void);
+char *read_line(char *buffer, int max_len);
+
+// shell
+typedef void (*command_handler_t)(int argc, char **argv);
+
+typedef struct {
+  const char *name;
+  const char *description;
+  command_handler_t handler;
+} command_t;
+
+#define SHELL_MAX_ARGS 16
+
+int register_command(command_t *cmd);
+int tokinaze(char *str, char **argv);
+void shell_run(int argc, char **argv);
+void shell_execute(char *input);
+
+// basic functions
+void *memset(void *ptr, int value, size_t num);
+void *mem_cpy(void *dest, void *src, size_t n);
+char *strcpy(char *dest, const char *src);
+size_t str_len(const char *str);
+int strcmp(const char *s1, const char *s2);
+
+// RAM FS
+int fs_write_file(char *name, char *content);
+uint32_t fs_append_file(char *name, char *data, uint32_t len);
+
+// hard drive FS
+// Смонтированный диск: в памяти только суперблок, таблица inode
+// подгружается страницами через fs_inode
+struct FileSystem {
+  struct SuperBlock superblock;
+};
+
+extern struct FileSystem hd_fs;
+extern int hd_mounted;
+int fs_find_hd(struct FileSystem *fs, char *name);
+struct DiskFileEntry *fs_inode(struct FileSystem *fs, uint32_t ino);
+
+#endif
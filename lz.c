@@ -0,0 +1,166 @@
+#include "lz.h"
+
+#define LZ_MIN_MATCH 4
+#define LZ_LAST_LITERALS 5 // последние байты всегда литералы
+#define LZ_MFLIMIT 12      // совпадение начинается не ближе к концу
+#define LZ_MAX_OFFSET 65535
+
+static uint32_t lz_read32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t lz_hash(uint32_t v) {
+  return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static void lz_copy(uint8_t *dst, const uint8_t *src, uint32_t n) {
+  while (n--) {
+    *dst++ = *src++;
+  }
+}
+
+static uint8_t *lz_put_length(uint8_t *op, uint32_t n) {
+  while (n >= 255) {
+    *op++ = 255;
+    n -= 255;
+  }
+  *op++ = n;
+  return op;
+}
+
+// Последовательность: литералы [anchor, anchor + lit) и совпадение
+static uint8_t *lz_emit(uint8_t *op, uint8_t *oend, const uint8_t *anchor,
+                        uint32_t lit, uint32_t offset, uint32_t mlen) {
+  // Худший случай длины: токен, продолжения обеих длин, смещение
+  if ((uint32_t)(oend - op) < 1 + lit + lit / 255 + 1 + 2 + mlen / 255 + 1) {
+    return 0;
+  }
+  uint8_t *token = op++;
+  *token = (lit >= 15 ? 15 : lit) << 4;
+  if (lit >= 15) {
+    op = lz_put_length(op, lit - 15);
+  }
+  lz_copy(op, anchor, lit);
+  op += lit;
+  if (offset == 0) {
+    return op; // последняя последовательность, только литералы
+  }
+  *op++ = offset & 0xFF;
+  *op++ = offset >> 8;
+  *token |= mlen >= 15 ? 15 : mlen;
+  if (mlen >= 15) {
+    op = lz_put_length(op, mlen - 15);
+  }
+  return op;
+}
+
+uint32_t lz_compress(const uint8_t *src, uint32_t len, uint8_t *dst,
+                     uint32_t cap, uint16_t *table) {
+  const uint8_t *ip = src;
+  const uint8_t *anchor = src;
+  const uint8_t *end = src + len;
+  uint8_t *op = dst;
+  uint8_t *oend = dst + cap;
+
+  if (len > LZ_MAX_INPUT) {
+    return 0;
+  }
+  for (int i = 0; i < LZ_HASH_SIZE; i++) {
+    table[i] = 0;
+  }
+  if (len > LZ_MFLIMIT) {
+    const uint8_t *limit = end - LZ_MFLIMIT;
+    const uint8_t *match_limit = end - LZ_LAST_LITERALS;
+
+    while (ip < limit) {
+      uint32_t h = lz_hash(lz_read32(ip));
+      uint32_t cand = table[h]; // позиция + 1, 0 - пусто
+      table[h] = (uint16_t)(ip - src + 1);
+      if (cand == 0) {
+        ip++;
+        continue;
+      }
+      const uint8_t *ref = src + cand - 1;
+      if (ip - ref > LZ_MAX_OFFSET || lz_read32(ref) != lz_read32(ip)) {
+        ip++;
+        continue;
+      }
+      while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+        ip--;
+        ref--;
+      }
+      const uint8_t *mp = ip + LZ_MIN_MATCH;
+      const uint8_t *mr = ref + LZ_MIN_MATCH;
+      while (mp < match_limit && *mp == *mr) {
+        mp++;
+        mr++;
+      }
+      op = lz_emit(op, oend, anchor, ip - anchor, ip - ref,
+                   mp - ip - LZ_MIN_MATCH);
+      if (!op) {
+        return 0;
+      }
+      ip = mp;
+      anchor = ip;
+    }
+  }
+  op = lz_emit(op, oend, anchor, end - anchor, 0, 0);
+  return op ? (uint32_t)(op - dst) : 0;
+}
+
+static int lz_get_length(const uint8_t **ip, const uint8_t *iend,
+                         uint32_t *n) {
+  uint8_t b;
+  do {
+    if (*ip >= iend) {
+      return -1;
+    }
+    b = *(*ip)++;
+    *n += b;
+  } while (b == 255);
+  return 0;
+}
+
+int lz_decompress(const uint8_t *src, uint32_t len, uint8_t *dst,
+                  uint32_t cap) {
+  const uint8_t *ip = src;
+  const uint8_t *iend = src + len;
+  uint8_t *op = dst;
+  uint8_t *oend = dst + cap;
+
+  while (ip < iend) {
+    uint32_t token = *ip++;
+    uint32_t lit = token >> 4;
+    if (lit == 15 && lz_get_length(&ip, iend, &lit) != 0) {
+      return -1;
+    }
+    if (lit > (uint32_t)(iend - ip) || lit > (uint32_t)(oend - op)) {
+      return -1;
+    }
+    lz_copy(op, ip, lit);
+    ip += lit;
+    op += lit;
+    if (ip == iend) {
+      break;
+    }
+
+    if (iend - ip < 2) {
+      return -1;
+    }
+    uint32_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    uint32_t mlen = token & 15;
+    if (mlen == 15 && lz_get_length(&ip, iend, &mlen) != 0) {
+      return -1;
+    }
+    mlen += LZ_MIN_MATCH;
+    if (offset == 0 || offset > (uint32_t)(op - dst) ||
+        mlen > (uint32_t)(oend - op)) {
+      return -1;
+    }
+    // Байт за байтом: совпадение может перекрывать само себя
+    lz_copy(op, op - offset, mlen);
+    op += mlen;
+  }
+  return op - dst;
+}
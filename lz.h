@@ -0,0 +1,27 @@
+#ifndef KERNEL_LZ_H
+#define KERNEL_LZ_H
+
+// Сжатие в формате блока LZ4: токен (4 бита длины литералов, 4 бита длины
+// совпадения - 4), литералы, смещение 16 бит, продолжения длин байтами 255.
+// Без кадров и контрольных сумм. Общее для ядра и tools/mkkeprfs.c
+
+#ifdef KEPROS_HOST
+#include <stdint.h>
+#else
+#include "types.h"
+#endif
+
+#define LZ_MAX_INPUT 65535 // позиции в хэш-таблице 16-битные
+#define LZ_HASH_BITS 12
+#define LZ_HASH_SIZE (1 << LZ_HASH_BITS)
+
+// Сжатие src в dst не длиннее cap; table - LZ_HASH_SIZE элементов рабочей
+// памяти. Возвращает длину или 0, если результат не помещается в cap
+uint32_t lz_compress(const uint8_t *src, uint32_t len, uint8_t *dst,
+                     uint32_t cap, uint16_t *table);
+
+// Длина распакованных данных или -1 для повреждённого входа
+int lz_decompress(const uint8_t *src, uint32_t len, uint8_t *dst,
+                  uint32_t cap);
+
+#endif
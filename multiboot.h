@@ -0,0 +1,55 @@
+#ifndef KERNEL_MULTIBOOT_H
+#define KERNEL_MULTIBOOT_H
+
+// Структура, которую загрузчик передаёт в ebx (Multiboot 0.6.96)
+
+#include "types.h"
+
+#define MULTIBOOT_BOOTLOADER_MAGIC 0x2BADB002
+
+#define MULTIBOOT_INFO_MEMORY 0x001
+#define MULTIBOOT_INFO_VBE 0x800
+#define MULTIBOOT_INFO_FRAMEBUFFER 0x1000
+
+#define MULTIBOOT_FRAMEBUFFER_TYPE_RGB 1
+#define MULTIBOOT_FRAMEBUFFER_TYPE_EGA_TEXT 2
+
+struct multiboot_info {
+  uint32_t flags;
+  uint32_t mem_lower; // KB ниже 1MB
+  uint32_t mem_upper; // KB выше 1MB
+  uint32_t boot_device;
+  uint32_t cmdline;
+  uint32_t mods_count;
+  uint32_t mods_addr;
+  uint32_t syms[4];
+  uint32_t mmap_length;
+  uint32_t mmap_addr;
+  uint32_t drives_length;
+  uint32_t drives_addr;
+  uint32_t config_table;
+  uint32_t boot_loader_name;
+  uint32_t apm_table;
+  uint32_t vbe_control_info;
+  uint32_t vbe_mode_info;
+  uint16_t vbe_mode;
+  uint16_t vbe_interface_seg;
+  uint16_t vbe_interface_off;
+  uint16_t vbe_interface_len;
+  uint32_t framebuffer_addr_low;
+  uint32_t framebuffer_addr_high;
+  uint32_t framebuffer_pitch;
+  uint32_t framebuffer_width;
+  uint32_t framebuffer_height;
+  uint8_t framebuffer_bpp;
+  uint8_t framebuffer_type;
+  // Для MULTIBOOT_FRAMEBUFFER_TYPE_RGB: положение и ширина каналов в точке
+  uint8_t framebuffer_red_field_position;
+  uint8_t framebuffer_red_mask_size;
+  uint8_t framebuffer_green_field_position;
+  uint8_t framebuffer_green_mask_size;
+  uint8_t framebuffer_blue_field_position;
+  uint8_t framebuffer_blue_mask_size;
+} __attribute__((packed));
+
+#endif
@@ -0,0 +1,514 @@
+#include "paging.h"
+#include "compress.h"
+#include "idt.h"
+#include "io.h"
+#include "kernel.h"
+#include "process.h"
+#include "tsc.h"
+
+#define CPUID_PSE (1 << 3)
+#define CPUID_PGE (1 << 13)
+#define CR0_WP 0x00010000
+#define CR0_PG 0x80000000
+#define CR4_PSE 0x10
+#define CR4_PGE 0x80
+
+#define MAX_VMAS 32
+#define PAGE_CACHE_PAGES 2048 // 8MB
+#define PAGE_CACHE_BUCKETS 256
+_Static_assert(FS_CHUNK_SIZE == PAGE_SIZE,
+               "page cache keeps one file chunk per page");
+
+#define VMA_DEVICE 1
+#define VMA_FILE 2
+
+extern char _kernel_start[], _rodata_end[], _kernel_end[];
+
+static uint32_t kernel_pd[1024] __attribute__((aligned(PAGE_SIZE)));
+static uint32_t low_pt[1024] __attribute__((aligned(PAGE_SIZE)));
+
+int paging_enabled = 0;
+struct paging_stats vm_stats;
+int (*user_fault_handler)(uint32_t addr, uint32_t err) = NULL;
+
+// Физические кадры: сначала свободный список, затем ещё не выданная память
+static uint32_t next_frame;
+static uint32_t frame_top;
+static uint32_t free_frames; // физический адрес головы списка, 0 - пусто
+
+struct vm_area {
+  uint32_t start;
+  uint32_t end;
+  uint8_t type;
+  int inode;
+};
+
+static struct vm_area vmas[MAX_VMAS];
+
+struct page_cache_entry {
+  int inode; // -1 - запись свободна
+  uint32_t index;
+  uint32_t phys;
+  uint32_t refs;
+  struct page_cache_entry *next;
+};
+
+static struct page_cache_entry page_cache[PAGE_CACHE_PAGES];
+static struct page_cache_entry *page_cache_hash[PAGE_CACHE_BUCKETS];
+static uint32_t page_cache_clock = 0;
+
+static inline void invlpg(uint32_t va) {
+  __asm__ volatile("invlpg (%0)" : : "r"(va) : "memory");
+}
+
+static uint32_t read_cr2(void) {
+  uint32_t value;
+  __asm__ volatile("mov %%cr2, %0" : "=r"(value));
+  return value;
+}
+
+uint32_t cmos_memory_kb(void) {
+  port_outb(0x34, 0x70);
+  uint32_t above_16m = port_inb(0x71);
+  port_outb(0x35, 0x70);
+  above_16m |= port_inb(0x71) << 8;
+  if (above_16m) {
+    return 16 * 1024 + above_16m * 64;
+  }
+  port_outb(0x17, 0x70);
+  uint32_t ext = port_inb(0x71);
+  port_outb(0x18, 0x70);
+  ext |= port_inb(0x71) << 8;
+  return 1024 + ext;
+}
+
+uint32_t frame_alloc(void) {
+  uint32_t frame = 0;
+
+  if (free_frames) {
+    frame = free_frames;
+    free_frames = *(uint32_t *)phys_to_virt(frame);
+  } else if (next_frame < frame_top) {
+    frame = next_frame;
+    next_frame += PAGE_SIZE;
+  } else {
+    return 0;
+  }
+  vm_stats.frames_used++;
+  return frame;
+}
+
+void frame_free(uint32_t phys) {
+  *(uint32_t *)phys_to_virt(phys) = free_frames;
+  free_frames = phys;
+  vm_stats.frames_used--;
+}
+
+static uint32_t *get_pte(uint32_t va, int create, uint32_t flags) {
+  uint32_t *pde = &kernel_pd[va >> 22];
+
+  if (!(*pde & PAGE_PRESENT)) {
+    if (!create) {
+      return NULL;
+    }
+    uint32_t pt = frame_alloc();
+    if (!pt) {
+      return NULL;
+    }
+    memset(phys_to_virt(pt), 0, PAGE_SIZE);
+    *pde = pt | PAGE_PRESENT | PAGE_WRITE | (flags & PAGE_USER);
+  } else if (*pde & PAGE_LARGE) {
+    return NULL;
+  }
+  uint32_t *pt = phys_to_virt(*pde & PAGE_MASK);
+  return &pt[(va >> 12) & 0x3FF];
+}
+
+int map_page(uint32_t va, uint32_t pa, uint32_t flags) {
+  uint32_t *pte = get_pte(va, 1, flags);
+  if (!pte) {
+    return -1;
+  }
+  *pte = (pa & PAGE_MASK) | flags | PAGE_PRESENT;
+  invlpg(va);
+  return 0;
+}
+
+void unmap_page(uint32_t va) {
+  uint32_t *pte = get_pte(va, 0, 0);
+  if (pte && (*pte & PAGE_PRESENT)) {
+    *pte = 0;
+    invlpg(va);
+  }
+}
+
+uint32_t lookup_page(uint32_t va) {
+  uint32_t *pte = get_pte(va, 0, 0);
+  return pte ? *pte : 0;
+}
+
+// Таблицы страниц пользовательской части (между первыми 4MB и PHYSMAP_BASE)
+void release_user_page_tables(void) {
+  for (uint32_t i = 1; i < (PHYSMAP_BASE >> 22); i++) {
+    if ((kernel_pd[i] & PAGE_PRESENT) && !(kernel_pd[i] & PAGE_LARGE)) {
+      frame_free(kernel_pd[i] & PAGE_MASK);
+    }
+    kernel_pd[i] = 0;
+  }
+  // Глобальные страницы ядра при перезагрузке CR3 остаются в TLB
+  __asm__ volatile("mov %0, %%cr3" : : "r"(kernel_pd) : "memory");
+}
+
+// Первый свободный участок в области vmap
+static struct vm_area *vma_alloc(uint32_t size) {
+  struct vm_area *slot = NULL;
+  uint32_t start = VMAP_BASE;
+  int moved = 1;
+
+  for (int i = 0; i < MAX_VMAS && !slot; i++) {
+    if (vmas[i].type == 0) {
+      slot = &vmas[i];
+    }
+  }
+  if (!slot) {
+    return NULL;
+  }
+  while (moved) {
+    moved = 0;
+    for (int i = 0; i < MAX_VMAS; i++) {
+      if (vmas[i].type && start < vmas[i].end && vmas[i].start < start + size) {
+        start = vmas[i].end;
+        moved = 1;
+      }
+    }
+    if (start + size > VMAP_END || start + size < start) {
+      return NULL;
+    }
+  }
+  slot->start = start;
+  slot->end = start + size;
+  return slot;
+}
+
+static struct vm_area *vma_find(uint32_t va) {
+  for (int i = 0; i < MAX_VMAS; i++) {
+    if (vmas[i].type && va >= vmas[i].start && va < vmas[i].end) {
+      return &vmas[i];
+    }
+  }
+  return NULL;
+}
+
+void *vmap(uint32_t phys, uint32_t size, uint32_t flags) {
+  uint32_t offset = phys & ~PAGE_MASK;
+  uint32_t len = (offset + size + PAGE_SIZE - 1) & PAGE_MASK;
+  struct vm_area *vma = vma_alloc(len);
+
+  if (!vma) {
+    return NULL;
+  }
+  vma->type = VMA_DEVICE;
+  for (uint32_t off = 0; off < len; off += PAGE_SIZE) {
+    if (map_page(vma->start + off, (phys & PAGE_MASK) + off,
+                 PAGE_WRITE | PAGE_GLOBAL | flags) != 0) {
+      vunmap((void *)vma->start);
+      return NULL;
+    }
+  }
+  return (void *)(vma->start + offset);
+}
+
+void vunmap(void *addr) {
+  struct vm_area *vma = vma_find((uint32_t)addr);
+  if (!vma || vma->type != VMA_DEVICE) {
+    return;
+  }
+  for (uint32_t va = vma->start; va < vma->end; va += PAGE_SIZE) {
+    unmap_page(va);
+  }
+  vma->type = 0;
+}
+
+// page cache: страницы файлов диска, ключ (inode, номер страницы)
+
+static uint32_t page_cache_bucket(int inode, uint32_t index) {
+  return (inode * 31 + index) % PAGE_CACHE_BUCKETS;
+}
+
+static void page_cache_unlink(struct page_cache_entry *e) {
+  struct page_cache_entry **p =
+      &page_cache_hash[page_cache_bucket(e->inode, e->index)];
+  while (*p != e) {
+    p = &(*p)->next;
+  }
+  *p = e->next;
+  e->inode = -1;
+}
+
+// Свободная запись или (по кругу) вытесняемая страница без ссылок
+static struct page_cache_entry *page_cache_slot(void) {
+  for (uint32_t n = 0; n < PAGE_CACHE_PAGES; n++) {
+    struct page_cache_entry *e = &page_cache[page_cache_clock];
+    page_cache_clock = (page_cache_clock + 1) % PAGE_CACHE_PAGES;
+    if (e->inode == -1) {
+      return e;
+    }
+    if (e->refs == 0) {
+      page_cache_unlink(e);
+      vm_stats.cache_evictions++;
+      return e;
+    }
+  }
+  return NULL;
+}
+
+uint32_t page_cache_get(int inode, uint32_t index) {
+  uint32_t bucket = page_cache_bucket(inode, index);
+
+  for (struct page_cache_entry *e = page_cache_hash[bucket]; e; e = e->next) {
+    if (e->inode == inode && e->index == index) {
+      e->refs++;
+      vm_stats.cache_hits++;
+      return e->phys;
+    }
+  }
+
+  struct page_cache_entry *e = page_cache_slot();
+  if (!e) {
+    return 0;
+  }
+  if (!e->phys) {
+    e->phys = frame_alloc();
+    if (!e->phys) {
+      return 0;
+    }
+  }
+
+  // Страница файла - один кусок FS_CHUNK_SIZE; сжатый распаковывается
+  fs_read_chunk(fs_inode(&hd_fs, inode), index, phys_to_virt(e->phys));
+
+  e->inode = inode;
+  e->index = index;
+  e->refs = 1;
+  e->next = page_cache_hash[bucket];
+  page_cache_hash[bucket] = e;
+  vm_stats.cache_misses++;
+  return e->phys;
+}
+
+void page_cache_put(int inode, uint32_t index) {
+  struct page_cache_entry *e =
+      page_cache_hash[page_cache_bucket(inode, index)];
+  for (; e; e = e->next) {
+    if (e->inode == inode && e->index == index && e->refs > 0) {
+      e->refs--;
+      return;
+    }
+  }
+}
+
+void *mmap_file(char *name, uint32_t *size) {
+  if (!paging_enabled || !hd_mounted) {
+    return NULL;
+  }
+  int inode = fs_find_hd(&hd_fs, name);
+  if (inode == -1) {
+    return NULL;
+  }
+  uint32_t file_size = fs_inode(&hd_fs, inode)->size;
+  uint32_t len = (file_size + PAGE_SIZE - 1) & PAGE_MASK;
+  struct vm_area *vma = vma_alloc(len ? len : PAGE_SIZE);
+  if (!vma) {
+    return NULL;
+  }
+  vma->type = VMA_FILE;
+  vma->inode = inode;
+  *size = file_size;
+  return (void *)vma->start;
+}
+
+void munmap_file(void *addr) {
+  struct vm_area *vma = vma_find((uint32_t)addr);
+  if (!vma || vma->type != VMA_FILE) {
+    return;
+  }
+  for (uint32_t va = vma->start; va < vma->end; va += PAGE_SIZE) {
+    uint32_t *pte = get_pte(va, 0, 0);
+    if (pte && (*pte & PAGE_PRESENT)) {
+      page_cache_put(vma->inode, (va - vma->start) / PAGE_SIZE);
+      unmap_page(va);
+    }
+  }
+  vma->type = 0;
+}
+
+static void page_fault_handler(struct regs *r) {
+  uint32_t addr = read_cr2();
+  struct vm_area *vma = vma_find(addr);
+
+  vm_stats.page_faults++;
+  // Ленивая подгрузка страницы файла; запись в такое отображение - ошибка
+  if (vma && vma->type == VMA_FILE &&
+      !(r->err_code & (PF_ERR_WRITE | PF_ERR_USER))) {
+    uint32_t va = addr & PAGE_MASK;
+    uint32_t phys = page_cache_get(vma->inode, (va - vma->start) / PAGE_SIZE);
+    if (phys && map_page(va, phys, PAGE_GLOBAL) == 0) {
+      return;
+    }
+  }
+
+  // Пользовательская часть: подкачка сегментов ELF и стека процесса
+  if (addr >= USER_BASE && addr < USER_TOP && user_fault_handler &&
+      user_fault_handler(addr, r->err_code) == 0) {
+    return;
+  }
+  // Без процесса контекста шелла для возврата нет: это ошибка ядра
+  if (user_exception_handler && process_running() &&
+      ((r->cs & 3) == 3 || (addr >= USER_BASE && addr < USER_TOP))) {
+    user_exception_handler(r);
+    return;
+  }
+
+  print_string("\nKERNEL PANIC: page fault at ");
+  print_hex(addr);
+  if (addr < PAGE_SIZE) {
+    print_string(" (NULL pointer)");
+  }
+  print_string(r->err_code & PF_ERR_WRITE ? " on write" : " on read");
+  print_string(", eip ");
+  print_hex(r->eip);
+  print_char('\n');
+  for (;;) {
+    __asm__ volatile("cli; hlt");
+  }
+}
+
+int paging_init(uint32_t mem_kb) {
+  uint32_t eax = 1, ebx, ecx, edx;
+  __asm__ volatile("cpuid" : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+  if (!(edx & CPUID_PSE)) {
+    print_string("paging: CPU has no PSE, paging disabled\n");
+    return -1;
+  }
+  uint32_t global = (edx & CPUID_PGE) ? PAGE_GLOBAL : 0;
+
+  uint32_t phys_top = mem_kb >= PHYSMAP_LIMIT / 1024 ? PHYSMAP_LIMIT
+                                                      : mem_kb * 1024;
+  phys_top &= PAGE_MASK;
+
+  // Первые 4MB: страница 0 не отображена, код ядра только для чтения
+  for (uint32_t i = 1; i < 1024; i++) {
+    uint32_t pa = i * PAGE_SIZE;
+    uint32_t flags = PAGE_PRESENT | PAGE_WRITE | global;
+    if (pa >= (uint32_t)_kernel_start && pa < (uint32_t)_rodata_end) {
+      flags &= ~PAGE_WRITE;
+    }
+    low_pt[i] = pa | flags;
+  }
+  kernel_pd[0] = (uint32_t)low_pt | PAGE_PRESENT | PAGE_WRITE;
+
+  for (uint32_t pa = 0; pa < phys_top; pa += LARGE_PAGE_SIZE) {
+    kernel_pd[(PHYSMAP_BASE + pa) >> 22] =
+        pa | PAGE_PRESENT | PAGE_WRITE | PAGE_LARGE | global;
+  }
+
+  next_frame = ((uint32_t)_kernel_end + PAGE_SIZE - 1) & PAGE_MASK;
+  frame_top = phys_top;
+  vm_stats.frames_total = (frame_top - next_frame) / PAGE_SIZE;
+  for (int i = 0; i < PAGE_CACHE_PAGES; i++) {
+    page_cache[i].inode = -1;
+  }
+
+  idt_set_handler(EXC_PAGE_FAULT, page_fault_handler);
+
+  uint32_t cr0, cr4;
+  __asm__ volatile("mov %0, %%cr3" : : "r"(kernel_pd));
+  __asm__ volatile("mov %%cr4, %0" : "=r"(cr4));
+  cr4 |= CR4_PSE | (global ? CR4_PGE : 0);
+  __asm__ volatile("mov %0, %%cr4" : : "r"(cr4));
+  __asm__ volatile("mov %%cr0, %0" : "=r"(cr0));
+  cr0 |= CR0_PG | CR0_WP;
+  __asm__ volatile("mov %0, %%cr0" : : "r"(cr0) : "memory");
+
+  paging_enabled = 1;
+  return 0;
+}
+
+void cmd_mem(int argc, char **argv) {
+  print_string("frames used ");
+  print_uint(vm_stats.frames_used);
+  print_string(" of ");
+  print_uint(vm_stats.frames_total);
+  print_string("\npage faults ");
+  print_uint(vm_stats.page_faults);
+  print_string("\npage cache hits ");
+  print_uint(vm_stats.cache_hits);
+  print_string(" misses ");
+  print_uint(vm_stats.cache_misses);
+  print_string(" evictions ");
+  print_uint(vm_stats.cache_evictions);
+  print_char('\n');
+}
+
+static uint32_t checksum(uint8_t *data, uint32_t len) {
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < len; i++) {
+    sum = sum * 31 + data[i];
+  }
+  return sum;
+}
+
+static void print_scan(char *label, uint32_t sum, uint32_t bytes,
+                       uint32_t us) {
+  print_string(label);
+  print_hex(sum);
+  print_string(", ");
+  print_uint(us);
+  print_string(" us, ");
+  print_throughput(bytes, us);
+  print_char('\n');
+}
+
+// Последовательный проход по файлу: копирование через буфер против mmap
+void cmd_mscan(int argc, char **argv) {
+  static uint8_t buffer[PAGE_SIZE];
+
+  if (argc < 2) {
+    print_string("need file name(mscan <filename>)\n");
+    return;
+  }
+  int inode = hd_mounted ? fs_find_hd(&hd_fs, argv[1]) : -1;
+  if (inode == -1) {
+    print_string("error: file not exist on disk\n");
+    return;
+  }
+  struct DiskFileEntry *file = fs_inode(&hd_fs, inode);
+
+  uint64_t start = rdtsc();
+  uint32_t sum = 0;
+  for (uint32_t index = 0; index < fs_chunk_count(file->size); index++) {
+    uint32_t len = file->size - index * PAGE_SIZE;
+    if (len > PAGE_SIZE) {
+      len = PAGE_SIZE;
+    }
+    fs_read_chunk(file, index, buffer);
+    for (uint32_t i = 0; i < len; i++) {
+      sum = sum * 31 + buffer[i];
+    }
+  }
+  print_scan("read: sum ", sum, file->size, tsc_to_us(rdtsc() - start));
+
+  for (int pass = 0; pass < 2; pass++) {
+    uint32_t size;
+    start = rdtsc();
+    uint8_t *data = mmap_file(argv[1], &size);
+    if (!data) {
+      print_string("mmap_file failed\n");
+      return;
+    }
+    sum = checksum(data, size);
+    munmap_file(data);
+    print_scan(pass ? "mmap (cached): sum " : "mmap: sum ", sum, size,
+               tsc_to_us(rdtsc() - start));
+  }
+}
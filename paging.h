@@ -0,0 +1,81 @@
+#ifndef KERNEL_PAGING_H
+#define KERNEL_PAGING_H
+
+// Страничная память, выделение физических кадров, vmap и mmap_file
+//
+// Адресное пространство:
+//   0x00000000 - 0x003FFFFF  ядро, 4KB страницы (страница 0 не отображена,
+//                            .text/.rodata только для чтения)
+//   0x00400000 - 0xBFFFFFFF  пользовательский процесс
+//   0xC0000000 - 0xDFFFFFFF  вся физическая память, 4MB (PSE) страницы
+//   0xE0000000 - 0xEFFFFFFF  vmap/mmap_file, 4KB страницы по требованию
+
+#include "types.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_MASK (~(PAGE_SIZE - 1))
+#define LARGE_PAGE_SIZE 0x400000
+
+#define PAGE_PRESENT 0x001
+#define PAGE_WRITE 0x002
+#define PAGE_USER 0x004
+#define PAGE_PCD 0x010
+#define PAGE_LARGE 0x080
+#define PAGE_GLOBAL 0x100
+#define PAGE_CACHED 0x200 // бит ОС: страница принадлежит page cache
+
+#define PF_ERR_PRESENT 0x1
+#define PF_ERR_WRITE 0x2
+#define PF_ERR_USER 0x4
+
+#define PHYSMAP_BASE 0xC0000000
+#define PHYSMAP_LIMIT 0x20000000
+#define VMAP_BASE 0xE0000000
+#define VMAP_END 0xF0000000
+#define USER_BASE 0x00400000
+#define USER_TOP PHYSMAP_BASE
+
+#define phys_to_virt(p) ((void *)((uint32_t)(p) + PHYSMAP_BASE))
+
+struct paging_stats {
+  uint32_t page_faults;
+  uint32_t cache_hits;
+  uint32_t cache_misses;
+  uint32_t cache_evictions;
+  uint32_t frames_used;
+  uint32_t frames_total;
+};
+
+extern int paging_enabled;
+extern struct paging_stats vm_stats;
+
+// Вызывается при page fault в [USER_BASE, USER_TOP); 0 - страница отображена
+extern int (*user_fault_handler)(uint32_t addr, uint32_t err);
+
+int paging_init(uint32_t mem_kb);
+uint32_t cmos_memory_kb(void);
+
+uint32_t frame_alloc(void);
+void frame_free(uint32_t phys);
+
+int map_page(uint32_t va, uint32_t pa, uint32_t flags);
+void unmap_page(uint32_t va);
+uint32_t lookup_page(uint32_t va);
+void release_user_page_tables(void);
+
+// Страница файла диска в page cache (счётчик ссылок +1); 0 - нет памяти
+uint32_t page_cache_get(int inode, uint32_t index);
+void page_cache_put(int inode, uint32_t index);
+
+void *vmap(uint32_t phys, uint32_t size, uint32_t flags);
+void vunmap(void *addr);
+
+// Отображение файла с диска: страницы читаются в page cache при первом
+// обращении (page fault) и отображаются без копирования, только для чтения
+void *mmap_file(char *name, uint32_t *size);
+void munmap_file(void *addr);
+
+void cmd_mem(int argc, char **argv);
+void cmd_mscan(int argc, char **argv);
+
+#endif
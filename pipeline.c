@@ -0,0 +1,381 @@
+#include "pipeline.h"
+#include "kernel.h"
+#include "stream.h"
+
+#define MAX_STAGES 6
+#define PIPELINE_DEPTH 2 // "source script | wc", где в script тоже есть '|'
+#define GREP_PATTERN_MAX 64
+#define GREP_LINE_MAX 1024
+#define HEAD_DEFAULT_LINES 10
+
+struct stage;
+
+struct filter {
+  const char *name;
+  int (*init)(struct stage *st, int argc, char **argv);
+  void (*consume)(void *ctx, char *data, uint32_t len);
+  void (*finish)(void *ctx);
+};
+
+struct stage {
+  struct stream *out;
+  union {
+    struct {
+      char pattern[GREP_PATTERN_MAX];
+      uint32_t pattern_len;
+      int invert;
+      char carry[GREP_LINE_MAX]; // строка, разорванная границей буфера
+      uint32_t carry_len;
+    } grep;
+    struct {
+      uint32_t lines, words, bytes;
+      int in_word;
+    } wc;
+    struct {
+      uint32_t left;
+    } head;
+  } u;
+};
+
+// Последняя стадия: экран (или внешний поток при вложенном вызове) либо файл
+struct sink {
+  struct stream *parent;
+  char *file;
+  uint32_t dropped;
+};
+
+// Свои стадии и потоки на каждый уровень вложенности: внутренний конвейер
+// не трогает потоки внешнего, пока тот выполняется
+static struct stage stages_pool[PIPELINE_DEPTH][MAX_STAGES];
+static struct stream streams_pool[PIPELINE_DEPTH][MAX_STAGES];
+static int pipeline_depth = 0;
+
+static uint32_t parse_uint(const char *s) {
+  uint32_t v = 0;
+  while (*s >= '0' && *s <= '9') {
+    v = v * 10 + (*s++ - '0');
+  }
+  return v;
+}
+
+// grep [-v] <pattern>
+
+static int contains(const char *text, uint32_t len, const char *pattern,
+                    uint32_t plen) {
+  if (plen == 0) {
+    return 1;
+  }
+  for (uint32_t i = 0; i + plen <= len; i++) {
+    if (text[i] == pattern[0]) {
+      uint32_t j = 1;
+      while (j < plen && text[i + j] == pattern[j]) {
+        j++;
+      }
+      if (j == plen) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+static int grep_init(struct stage *st, int argc, char **argv) {
+  int arg = 1;
+  st->u.grep.invert = 0;
+  if (arg < argc && !strcmp(argv[arg], "-v")) {
+    st->u.grep.invert = 1;
+    arg++;
+  }
+  if (arg >= argc || str_len(argv[arg]) >= GREP_PATTERN_MAX) {
+    print_string("usage: grep [-v] <pattern>\n");
+    return -1;
+  }
+  strcpy(st->u.grep.pattern, argv[arg]);
+  st->u.grep.pattern_len = str_len(argv[arg]);
+  st->u.grep.carry_len = 0;
+  return 0;
+}
+
+// Строка целиком внутри входного буфера уходит дальше по ссылке
+static void grep_line(struct stage *st, char *line, uint32_t len, int copy) {
+  int match =
+      contains(line, len, st->u.grep.pattern, st->u.grep.pattern_len);
+  if (match == st->u.grep.invert) {
+    return;
+  }
+  if (copy) {
+    stream_write(st->out, line, len);
+  } else {
+    stream_pass(st->out, line, len);
+  }
+}
+
+static void grep_carry(struct stage *st, char *data, uint32_t len) {
+  uint32_t room = GREP_LINE_MAX - st->u.grep.carry_len;
+  if (len > room) {
+    len = room;
+  }
+  mem_cpy(st->u.grep.carry + st->u.grep.carry_len, data, len);
+  st->u.grep.carry_len += len;
+}
+
+static void grep_consume(void *ctx, char *data, uint32_t len) {
+  struct stage *st = ctx;
+  uint32_t pos = 0;
+
+  if (st->u.grep.carry_len) {
+    while (pos < len && data[pos] != '\n') {
+      pos++;
+    }
+    if (pos == len) {
+      grep_carry(st, data, len);
+      return;
+    }
+    pos++;
+    grep_carry(st, data, pos);
+    grep_line(st, st->u.grep.carry, st->u.grep.carry_len, 1);
+    st->u.grep.carry_len = 0;
+  }
+  while (pos < len) {
+    uint32_t start = pos;
+    while (pos < len && data[pos] != '\n') {
+      pos++;
+    }
+    if (pos == len) {
+      grep_carry(st, data + start, len - start);
+      return;
+    }
+    pos++;
+    grep_line(st, data + start, pos - start, 0);
+  }
+}
+
+static void grep_finish(void *ctx) {
+  struct stage *st = ctx;
+  if (st->u.grep.carry_len) {
+    grep_line(st, st->u.grep.carry, st->u.grep.carry_len, 1);
+  }
+}
+
+// wc - строки, слова, байты
+
+static int wc_init(struct stage *st, int argc, char **argv) {
+  memset(&st->u.wc, 0, sizeof(st->u.wc));
+  return 0;
+}
+
+static void wc_consume(void *ctx, char *data, uint32_t len) {
+  struct stage *st = ctx;
+  st->u.wc.bytes += len;
+  for (uint32_t i = 0; i < len; i++) {
+    char c = data[i];
+    int space = c == ' ' || c == '\n' || c == '\t' || c == '\r';
+    if (c == '\n') {
+      st->u.wc.lines++;
+    }
+    if (!space && !st->u.wc.in_word) {
+      st->u.wc.words++;
+    }
+    st->u.wc.in_word = !space;
+  }
+}
+
+static void wc_print(struct stream *out, uint32_t value, char end) {
+  char buf[12];
+  int i = 11;
+  buf[i] = end;
+  do {
+    buf[--i] = '0' + value % 10;
+    value /= 10;
+  } while (value);
+  stream_write(out, &buf[i], 12 - i);
+}
+
+static void wc_finish(void *ctx) {
+  struct stage *st = ctx;
+  wc_print(st->out, st->u.wc.lines, ' ');
+  wc_print(st->out, st->u.wc.words, ' ');
+  wc_print(st->out, st->u.wc.bytes, '\n');
+}
+
+// head [-n N | N] - первые N строк
+
+static int head_init(struct stage *st, int argc, char **argv) {
+  st->u.head.left = HEAD_DEFAULT_LINES;
+  if (argc > 2 && !strcmp(argv[1], "-n")) {
+    st->u.head.left = parse_uint(argv[2]);
+  } else if (argc > 1) {
+    st->u.head.left = parse_uint(argv[1]);
+  }
+  return 0;
+}
+
+static void head_consume(void *ctx, char *data, uint32_t len) {
+  struct stage *st = ctx;
+  uint32_t n = 0;
+
+  while (n < len && st->u.head.left > 0) {
+    if (data[n++] == '\n') {
+      st->u.head.left--;
+    }
+  }
+  stream_pass(st->out, data, n);
+}
+
+static const struct filter filters[] = {
+    {"grep", grep_init, grep_consume, grep_finish},
+    {"wc", wc_init, wc_consume, wc_finish},
+    {"head", head_init, head_consume, NULL},
+    {NULL, NULL, NULL, NULL},
+};
+
+static const struct filter *find_filter(const char *name) {
+  for (int i = 0; filters[i].name; i++) {
+    if (!strcmp(filters[i].name, name)) {
+      return &filters[i];
+    }
+  }
+  return NULL;
+}
+
+static void sink_consume(void *ctx, char *data, uint32_t len) {
+  struct sink *sink = ctx;
+
+  if (sink->file) {
+    uint32_t written = fs_append_file(sink->file, data, len);
+    sink->dropped += len - written;
+  } else if (sink->parent) {
+    stream_pass(sink->parent, data, len);
+  } else {
+    for (uint32_t i = 0; i < len; i++) {
+      print_char(data[i]);
+    }
+  }
+}
+
+static void sink_finish(void *ctx) {
+  struct sink *sink = ctx;
+  if (sink->dropped) {
+    print_string("warning: ");
+    print_uint(sink->dropped);
+    print_string(" bytes did not fit into ");
+    print_string(sink->file);
+    print_char('\n');
+  }
+}
+
+int pipeline_needed(const char *input) {
+  int quote = 0;
+  for (; *input; input++) {
+    if (*input == '"') {
+      quote = !quote;
+    } else if (!quote && (*input == '|' || *input == '>')) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void pipeline_execute(char *input) {
+  char *parts[MAX_STAGES];
+  char *argvs[MAX_STAGES][SHELL_MAX_ARGS];
+  int argcs[MAX_STAGES];
+  const struct filter *stage_filter[MAX_STAGES];
+  char *redirect = NULL;
+  int count = 1;
+  int quote = 0;
+
+  parts[0] = input;
+  for (char *p = input; *p; p++) {
+    if (*p == '"') {
+      quote = !quote;
+    } else if (!quote && *p == '|') {
+      if (count == MAX_STAGES) {
+        print_string("error: too many pipeline stages\n");
+        return;
+      }
+      *p = '\0';
+      parts[count++] = p + 1;
+    } else if (!quote && *p == '>') {
+      *p = '\0';
+      redirect = p + 1;
+      break;
+    }
+  }
+
+  char *file_argv[SHELL_MAX_ARGS];
+  if (redirect && tokinaze(redirect, file_argv) != 1) {
+    print_string("error: need one file name after '>'\n");
+    return;
+  }
+  for (int i = 0; i < count; i++) {
+    argcs[i] = tokinaze(parts[i], argvs[i]);
+    if (argcs[i] == 0) {
+      print_string("error: empty pipeline stage\n");
+      return;
+    }
+    if (i == 0) {
+      continue;
+    }
+    stage_filter[i] = find_filter(argvs[i][0]);
+    if (!stage_filter[i]) {
+      print_string("error: not a filter: ");
+      print_string(argvs[i][0]);
+      print_string(" (filters: grep, wc, head)\n");
+      return;
+    }
+  }
+
+  if (pipeline_depth == PIPELINE_DEPTH) {
+    print_string("error: pipelines nested too deep\n");
+    return;
+  }
+  struct stage *stages = stages_pool[pipeline_depth];
+  struct stream *streams = streams_pool[pipeline_depth];
+
+  // streams[i] - вход стадии i + 1; streams[count - 1] - приёмник
+  struct sink sink = {shell_out, NULL, 0};
+  struct stream *saved_out = shell_out;
+  if (redirect) {
+    sink.file = file_argv[0];
+    if (fs_write_file(sink.file, "") != 0) {
+      print_string("error: cannot create file ");
+      print_string(sink.file);
+      print_char('\n');
+      return;
+    }
+  }
+
+  if (stream_open(&streams[count - 1], sink_consume, sink_finish, &sink) !=
+      0) {
+    print_string("error: out of pipe buffers\n");
+    return;
+  }
+  for (int i = count - 1; i >= 1; i--) {
+    stages[i].out = &streams[i];
+    int failed = stage_filter[i]->init(&stages[i], argcs[i], argvs[i]);
+    if (!failed && stream_open(&streams[i - 1], stage_filter[i]->consume,
+                               stage_filter[i]->finish, &stages[i]) != 0) {
+      print_string("error: out of pipe buffers\n");
+      failed = 1;
+    }
+    // Уже открытые потоки освобождаются без finish: иначе wc напечатал
+    // бы "0 0 0" после сообщения об ошибке
+    if (failed) {
+      for (int j = i; j < count; j++) {
+        stream_abort(&streams[j]);
+      }
+      return;
+    }
+  }
+
+  pipeline_depth++;
+  shell_out = &streams[0];
+  shell_run(argcs[0], argvs[0]);
+  shell_out = saved_out;
+  pipeline_depth--;
+
+  for (int i = 0; i < count; i++) {
+    stream_close(&streams[i]);
+  }
+}
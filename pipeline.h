@@ -0,0 +1,10 @@
+#ifndef KERNEL_PIPELINE_H
+#define KERNEL_PIPELINE_H
+
+// Конвейеры шелла: "cmd | filter ... [> file]". Первая стадия - обычная
+// команда или программа, остальные - встроенные фильтры (grep, wc, head).
+
+int pipeline_needed(const char *input);
+void pipeline_execute(char *input);
+
+#endif
@@ -0,0 +1,520 @@
+#include "process.h"
+#include "gdt.h"
+#include "idt.h"
+#include "irq.h"
+#include "kernel.h"
+#include "paging.h"
+#include "stream.h"
+#include "syscall.h"
+
+#define MSR_SYSENTER_CS 0x174
+#define MSR_SYSENTER_ESP 0x175
+#define MSR_SYSENTER_EIP 0x176
+#define CPUID_SEP (1 << 11)
+
+#define KSTACK_SIZE 16384
+#define USER_STACK_SIZE (256 * 1024)
+#define MAX_SEGMENTS 8
+#define MAX_PHDRS 16
+#define MAX_FDS 8
+#define FD_FIRST_FILE 3
+
+#define ELF_MAGIC 0x464C457F // "\x7FELF"
+#define ET_EXEC 2
+#define EM_386 3
+#define PT_LOAD 1
+#define PF_W 2
+
+struct elf_header {
+  uint32_t magic;
+  uint8_t ident[12];
+  uint16_t type;
+  uint16_t machine;
+  uint32_t version;
+  uint32_t entry;
+  uint32_t phoff;
+  uint32_t shoff;
+  uint32_t flags;
+  uint16_t ehsize;
+  uint16_t phentsize;
+  uint16_t phnum;
+  uint16_t shentsize;
+  uint16_t shnum;
+  uint16_t shstrndx;
+};
+
+struct elf_phdr {
+  uint32_t type;
+  uint32_t offset;
+  uint32_t vaddr;
+  uint32_t paddr;
+  uint32_t filesz;
+  uint32_t memsz;
+  uint32_t flags;
+  uint32_t align;
+};
+
+// Участок адресного пространства процесса; страницы подгружаются при
+// первом обращении. Стек - участок без данных из файла (filesz = 0).
+struct segment {
+  uint32_t start;
+  uint32_t end;
+  uint32_t vaddr;
+  uint32_t offset;
+  uint32_t filesz;
+  uint8_t writable;
+};
+
+struct file_desc {
+  int inode;
+  uint32_t offset;
+  int used;
+};
+
+struct kcontext {
+  uint32_t ebx, esi, edi, ebp, esp, eip;
+};
+
+struct process {
+  int running;
+  int pid;
+  int inode;
+  struct segment segs[MAX_SEGMENTS];
+  int nsegs;
+  struct file_desc fds[MAX_FDS];
+  int exit_code;
+};
+
+int sysenter_supported = 0;
+
+static struct process current;
+static struct kcontext shell_context;
+static uint8_t kernel_stack[KSTACK_SIZE] __attribute__((aligned(16)));
+static int next_pid = 1;
+
+int ctx_save(struct kcontext *ctx) __attribute__((returns_twice));
+void ctx_restore(struct kcontext *ctx, int value) __attribute__((noreturn));
+void enter_user(uint32_t entry, uint32_t esp) __attribute__((noreturn));
+void sysenter_entry(void);
+
+// ctx_save/ctx_restore - setjmp/longjmp для возврата в шелл после exit.
+// sysenter_entry: ecx/edx (esp и eip пользователя) сохраняются для sysexit,
+// аргументы eax/ebx/esi/edi передаются в syscall_dispatch.
+__asm__(".text\n"
+        ".globl ctx_save\n"
+        "ctx_save:\n"
+        "  movl 4(%esp), %eax\n"
+        "  movl %ebx, 0(%eax)\n"
+        "  movl %esi, 4(%eax)\n"
+        "  movl %edi, 8(%eax)\n"
+        "  movl %ebp, 12(%eax)\n"
+        "  leal 4(%esp), %ecx\n"
+        "  movl %ecx, 16(%eax)\n"
+        "  movl (%esp), %ecx\n"
+        "  movl %ecx, 20(%eax)\n"
+        "  xorl %eax, %eax\n"
+        "  ret\n"
+        ".globl ctx_restore\n"
+        "ctx_restore:\n"
+        "  movl 4(%esp), %edx\n"
+        "  movl 8(%esp), %eax\n"
+        "  movl 0(%edx), %ebx\n"
+        "  movl 4(%edx), %esi\n"
+        "  movl 8(%edx), %edi\n"
+        "  movl 12(%edx), %ebp\n"
+        "  movl 16(%edx), %esp\n"
+        "  jmp *20(%edx)\n"
+        ".globl enter_user\n"
+        "enter_user:\n"
+        "  movl 4(%esp), %ecx\n"
+        "  movl 8(%esp), %edx\n"
+        "  movw $0x23, %ax\n" // USER_DS
+        "  movw %ax, %ds\n"
+        "  movw %ax, %es\n"
+        "  movw %ax, %fs\n"
+        "  movw %ax, %gs\n"
+        "  pushl $0x23\n"
+        "  pushl %edx\n"
+        "  pushfl\n"
+        "  orl $0x200, (%esp)\n" // IF: в ring 3 прерывания включены
+        "  pushl $0x1B\n" // USER_CS
+        "  pushl %ecx\n"
+        "  iret\n"
+        ".globl sysenter_entry\n"
+        "sysenter_entry:\n"
+        "  pushl %ecx\n"
+        "  pushl %edx\n"
+        "  pushl %ds\n"
+        "  pushl %es\n"
+        "  pushl %edi\n"
+        "  pushl %esi\n"
+        "  pushl %ebx\n"
+        "  pushl %eax\n"
+        "  movw $0x10, %ax\n" // KERNEL_DS
+        "  movw %ax, %ds\n"
+        "  movw %ax, %es\n"
+        "  sti\n" // sysenter выключает прерывания
+        "  call syscall_dispatch\n"
+        "  addl $16, %esp\n"
+        "  popl %es\n"
+        "  popl %ds\n"
+        "  popl %edx\n"
+        "  popl %ecx\n"
+        "  sti\n" // IRQ после sti откладывается до sysexit
+        "  sysexit\n");
+
+static inline void wrmsr(uint32_t msr, uint32_t value) {
+  __asm__ volatile("wrmsr" : : "c"(msr), "a"(value), "d"(0));
+}
+
+// Чтение файла диска через page cache
+static uint32_t file_read(int inode, uint32_t offset, void *buf, uint32_t len) {
+  uint32_t size = fs_inode(&hd_fs, inode)->size;
+  uint8_t *out = buf;
+  uint32_t done = 0;
+
+  if (offset >= size) {
+    return 0;
+  }
+  if (len > size - offset) {
+    len = size - offset;
+  }
+  while (done < len) {
+    uint32_t index = (offset + done) / PAGE_SIZE;
+    uint32_t in_page = (offset + done) % PAGE_SIZE;
+    uint32_t n = PAGE_SIZE - in_page;
+    if (n > len - done) {
+      n = len - done;
+    }
+    uint32_t phys = page_cache_get(inode, index);
+    if (!phys) {
+      break;
+    }
+    mem_cpy(out + done, (uint8_t *)phys_to_virt(phys) + in_page, n);
+    page_cache_put(inode, index);
+    done += n;
+  }
+  return done;
+}
+
+static struct segment *find_segment(uint32_t addr) {
+  for (int i = 0; i < current.nsegs; i++) {
+    if (addr >= current.segs[i].start && addr < current.segs[i].end) {
+      return &current.segs[i];
+    }
+  }
+  return NULL;
+}
+
+static int user_fault(uint32_t addr, uint32_t err) {
+  struct segment *seg = current.running ? find_segment(addr) : NULL;
+  if (!seg || (err & PF_ERR_PRESENT)) {
+    return -1;
+  }
+  uint32_t va = addr & PAGE_MASK;
+
+  // Страница кода целиком из файла: отображаем страницу page cache напрямую
+  if (!seg->writable && ((seg->vaddr - seg->offset) & ~PAGE_MASK) == 0 &&
+      va >= seg->vaddr && va + PAGE_SIZE <= seg->vaddr + seg->filesz) {
+    uint32_t index = (seg->offset + (va - seg->vaddr)) / PAGE_SIZE;
+    uint32_t phys = page_cache_get(current.inode, index);
+    if (!phys) {
+      return -1;
+    }
+    if (map_page(va, phys, PAGE_USER | PAGE_CACHED) != 0) {
+      page_cache_put(current.inode, index);
+      return -1;
+    }
+    return 0;
+  }
+
+  uint32_t frame = frame_alloc();
+  if (!frame) {
+    return -1;
+  }
+  uint8_t *page = phys_to_virt(frame);
+  memset(page, 0, PAGE_SIZE);
+
+  uint32_t lo = va > seg->vaddr ? va : seg->vaddr;
+  uint32_t hi = va + PAGE_SIZE;
+  if (hi > seg->vaddr + seg->filesz) {
+    hi = seg->vaddr + seg->filesz;
+  }
+  if (lo < hi) {
+    file_read(current.inode, seg->offset + (lo - seg->vaddr), page + (lo - va),
+              hi - lo);
+  }
+  if (map_page(va, frame, PAGE_USER | (seg->writable ? PAGE_WRITE : 0)) != 0) {
+    frame_free(frame);
+    return -1;
+  }
+  return 0;
+}
+
+static void process_release(void) {
+  for (int i = 0; i < current.nsegs; i++) {
+    struct segment *seg = &current.segs[i];
+    for (uint32_t va = seg->start; va < seg->end; va += PAGE_SIZE) {
+      uint32_t pte = lookup_page(va);
+      if (!(pte & PAGE_PRESENT)) {
+        continue;
+      }
+      if (pte & PAGE_CACHED) {
+        page_cache_put(current.inode,
+                       (seg->offset + (va - seg->vaddr)) / PAGE_SIZE);
+      } else {
+        frame_free(pte & PAGE_MASK);
+      }
+    }
+  }
+  release_user_page_tables();
+  current.nsegs = 0;
+  current.running = 0;
+}
+
+int process_running(void) { return current.running; }
+
+static void process_exit(int code) {
+  current.exit_code = code;
+  ctx_restore(&shell_context, 1);
+}
+
+static void user_exception(struct regs *r) {
+  print_string("\nprocess ");
+  print_uint(current.pid);
+  print_string(" killed: exception ");
+  print_uint(r->vector);
+  print_string(" at eip ");
+  print_hex(r->eip);
+  print_char('\n');
+  process_exit(-1);
+}
+
+static int user_range_ok(uint32_t addr, uint32_t len) {
+  return addr >= USER_BASE && addr + len >= addr && addr + len <= USER_TOP;
+}
+
+static int sys_read(int fd, uint8_t *buf, uint32_t len) {
+  if (!user_range_ok((uint32_t)buf, len)) {
+    return -1;
+  }
+  if (fd == 0) {
+    static char line[256];
+    read_line(line, sizeof(line));
+    uint32_t n = str_len(line);
+    if (n > len) {
+      n = len;
+    }
+    mem_cpy(buf, line, n);
+    if (n < len) {
+      buf[n++] = '\n';
+    }
+    return n;
+  }
+  if (fd < FD_FIRST_FILE || fd >= MAX_FDS || !current.fds[fd].used) {
+    return -1;
+  }
+  struct file_desc *f = &current.fds[fd];
+  uint32_t n = file_read(f->inode, f->offset, buf, len);
+  f->offset += n;
+  return n;
+}
+
+static int sys_write(int fd, char *buf, uint32_t len) {
+  if (!user_range_ok((uint32_t)buf, len) || (fd != 1 && fd != 2)) {
+    return -1;
+  }
+  if (fd == 1) {
+    sh_write(buf, len); // stdout может идти в конвейер
+    return len;
+  }
+  for (uint32_t i = 0; i < len; i++) {
+    print_char(buf[i]);
+  }
+  return len;
+}
+
+static int sys_open(char *path) {
+  char name[DISK_FILENAME];
+  int i;
+
+  for (i = 0; i < DISK_FILENAME; i++) {
+    if (!user_range_ok((uint32_t)path + i, 1)) {
+      return -1;
+    }
+    name[i] = path[i];
+    if (name[i] == '\0') {
+      break;
+    }
+  }
+  if (i == DISK_FILENAME) {
+    return -1;
+  }
+  int inode = fs_find_hd(&hd_fs, name);
+  if (inode == -1) {
+    return -1;
+  }
+  for (int fd = FD_FIRST_FILE; fd < MAX_FDS; fd++) {
+    if (!current.fds[fd].used) {
+      current.fds[fd].used = 1;
+      current.fds[fd].inode = inode;
+      current.fds[fd].offset = 0;
+      return fd;
+    }
+  }
+  return -1;
+}
+
+static int sys_close(int fd) {
+  if (fd < FD_FIRST_FILE || fd >= MAX_FDS || !current.fds[fd].used) {
+    return -1;
+  }
+  current.fds[fd].used = 0;
+  return 0;
+}
+
+int syscall_dispatch(uint32_t nr, uint32_t a1, uint32_t a2, uint32_t a3) {
+  switch (nr) {
+  case SYS_EXIT:
+    process_exit(a1);
+    return 0;
+  case SYS_READ:
+    return sys_read(a1, (uint8_t *)a2, a3);
+  case SYS_WRITE:
+    return sys_write(a1, (char *)a2, a3);
+  case SYS_OPEN:
+    return sys_open((char *)a1);
+  case SYS_CLOSE:
+    return sys_close(a1);
+  case SYS_GETPID:
+    return current.pid;
+  default:
+    return -1;
+  }
+}
+
+static void syscall_interrupt(struct regs *r) {
+  r->eax = syscall_dispatch(r->eax, r->ebx, r->esi, r->edi);
+}
+
+static int add_segment(uint32_t vaddr, uint32_t memsz, uint32_t offset,
+                       uint32_t filesz, int writable) {
+  if (current.nsegs == MAX_SEGMENTS || filesz > memsz ||
+      !user_range_ok(vaddr, memsz)) {
+    return -1;
+  }
+  struct segment *seg = &current.segs[current.nsegs++];
+  seg->start = vaddr & PAGE_MASK;
+  seg->end = (vaddr + memsz + PAGE_SIZE - 1) & PAGE_MASK;
+  seg->vaddr = vaddr;
+  seg->offset = offset;
+  seg->filesz = filesz;
+  seg->writable = writable;
+  return 0;
+}
+
+static int load_elf(int inode, uint32_t *entry) {
+  struct elf_header eh;
+  struct elf_phdr ph;
+
+  if (file_read(inode, 0, &eh, sizeof(eh)) != sizeof(eh) ||
+      eh.magic != ELF_MAGIC || eh.type != ET_EXEC || eh.machine != EM_386 ||
+      eh.phentsize != sizeof(ph) || eh.phnum > MAX_PHDRS) {
+    return -1;
+  }
+  current.nsegs = 0;
+  for (int i = 0; i < eh.phnum; i++) {
+    if (file_read(inode, eh.phoff + i * sizeof(ph), &ph, sizeof(ph)) !=
+        sizeof(ph)) {
+      return -1;
+    }
+    if (ph.type == PT_LOAD && ph.memsz > 0 &&
+        add_segment(ph.vaddr, ph.memsz, ph.offset, ph.filesz,
+                    (ph.flags & PF_W) != 0) != 0) {
+      return -1;
+    }
+  }
+  if (add_segment(USER_TOP - USER_STACK_SIZE, USER_STACK_SIZE, 0, 0, 1) != 0) {
+    return -1;
+  }
+  *entry = eh.entry;
+  return 0;
+}
+
+// argc/argv на стеке пользователя, как при вызове _start(argc, argv)
+static uint32_t setup_stack(int argc, char **argv) {
+  uint32_t sp = USER_TOP;
+  uint32_t uargv[16];
+
+  for (int i = argc - 1; i >= 0; i--) {
+    uint32_t len = str_len(argv[i]) + 1;
+    sp -= len;
+    mem_cpy((void *)sp, argv[i], len);
+    uargv[i] = sp;
+  }
+  sp &= ~3u;
+  sp -= (argc + 1) * 4;
+  uint32_t *up = (uint32_t *)sp;
+  for (int i = 0; i < argc; i++) {
+    up[i] = uargv[i];
+  }
+  up[argc] = 0;
+  uint32_t argv_ptr = sp;
+  sp -= 12;
+  up = (uint32_t *)sp;
+  up[0] = 0; // адрес возврата
+  up[1] = argc;
+  up[2] = argv_ptr;
+  return sp;
+}
+
+int process_exec(int argc, char **argv) {
+  if (!paging_enabled || !hd_mounted || argc > 16) {
+    return EXEC_NOT_FOUND;
+  }
+  int inode = fs_find_hd(&hd_fs, argv[0]);
+  if (inode == -1) {
+    return EXEC_NOT_FOUND;
+  }
+
+  uint32_t entry;
+  memset(&current, 0, sizeof(current));
+  current.inode = inode;
+  if (load_elf(inode, &entry) != 0) {
+    current.nsegs = 0;
+    print_string(argv[0]);
+    print_string(": not an i386 ELF executable\n");
+    return EXEC_BAD_FORMAT;
+  }
+  current.pid = next_pid++;
+  current.running = 1;
+
+  // Выход через int 0x80 или исключение приходит сюда с IF=0
+  int irq_on = irqs_enabled();
+  if (ctx_save(&shell_context) == 0) {
+    enter_user(entry, setup_stack(argc, argv));
+  }
+  if (irq_on) {
+    __asm__ volatile("sti");
+  }
+  process_release();
+  return current.exit_code;
+}
+
+void process_init(void) {
+  uint32_t top = (uint32_t)kernel_stack + KSTACK_SIZE;
+  uint32_t eax = 1, ebx, ecx, edx;
+
+  user_fault_handler = user_fault;
+  user_exception_handler = user_exception;
+  idt_set_handler(SYSCALL_VECTOR, syscall_interrupt);
+  tss_set_kernel_stack(top);
+
+  __asm__ volatile("cpuid" : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+  if (edx & CPUID_SEP) {
+    wrmsr(MSR_SYSENTER_CS, KERNEL_CS);
+    wrmsr(MSR_SYSENTER_ESP, top);
+    wrmsr(MSR_SYSENTER_EIP, (uint32_t)sysenter_entry);
+    sysenter_supported = 1;
+  }
+}
@@ -0,0 +1,24 @@
+#ifndef KERNEL_PROCESS_H
+#define KERNEL_PROCESS_H
+
+// Пользовательские процессы (ring 3): загрузка ELF с диска, системные
+// вызовы через sysenter/sysexit и int 0x80. Одновременно работает один
+// процесс; шелл ждёт его завершения.
+
+#include "types.h"
+
+#define EXEC_NOT_FOUND -1
+#define EXEC_BAD_FORMAT -2
+
+extern int sysenter_supported;
+
+void process_init(void);
+
+// 1 - пользовательский процесс запущен и исключение можно отдать ему
+int process_running(void);
+
+// Запуск программы argv[0] с диска. Возвращает код выхода процесса или
+// EXEC_NOT_FOUND / EXEC_BAD_FORMAT
+int process_exec(int argc, char **argv);
+
+#endif
@@ -0,0 +1,160 @@
+#include "raid0.h"
+#include "kernel.h"
+
+struct raid0 {
+  struct block_device dev;
+  struct block_device *members[RAID0_MAX_MEMBERS];
+  int count;
+  uint32_t chunk;
+};
+
+// Состояние одного диска массива во время запроса
+struct raid0_io {
+  struct blk_request rq;
+  uint32_t next; // смещение в запросе, с которого искать следующий кусок
+  int active;
+};
+
+static struct raid0 arrays[RAID0_MAX_ARRAYS];
+static int array_count = 0;
+
+// Первый кусок запроса [lba, lba + count) на диске member, начиная со
+// смещения off; возвращает count, если кусков больше нет
+static uint32_t raid0_next(struct raid0 *r, uint32_t lba, uint32_t count,
+                           uint32_t off, int member, uint32_t *len) {
+  while (off < count) {
+    uint32_t s = lba + off;
+    uint32_t n = r->chunk - s % r->chunk;
+    if (n > count - off) {
+      n = count - off;
+    }
+    if ((int)((s / r->chunk) % r->count) == member) {
+      *len = n;
+      return off;
+    }
+    off += n;
+  }
+  return count;
+}
+
+static int raid0_rw(struct block_device *dev, uint32_t lba, uint8_t *buf,
+                    uint32_t count, int write) {
+  struct raid0 *r = dev->priv;
+  struct raid0_io io[RAID0_MAX_MEMBERS];
+  int status = 0;
+
+  for (int i = 0; i < r->count; i++) {
+    io[i].next = 0;
+    io[i].active = 0;
+  }
+  for (;;) {
+    int pending = 0;
+    for (int i = 0; i < r->count; i++) {
+      struct raid0_io *m = &io[i];
+      if (m->active && blk_poll(r->members[i], &m->rq)) {
+        m->active = 0;
+        if (m->rq.status != 0) {
+          status = BLK_EIO;
+        }
+      }
+      if (!m->active && status == 0) {
+        uint32_t len;
+        uint32_t off = raid0_next(r, lba, count, m->next, i, &len);
+        m->next = off;
+        if (off < count) {
+          uint32_t s = lba + off;
+          uint32_t stripe = s / r->chunk;
+          memset(&m->rq, 0, sizeof(m->rq));
+          m->rq.lba = (stripe / r->count) * r->chunk + s % r->chunk;
+          m->rq.buf = buf + off * SECTOR_SIZE;
+          m->rq.count = len;
+          m->rq.write = write;
+          int rc = blk_submit(r->members[i], &m->rq);
+          if (rc == 0) {
+            m->active = 1;
+            m->next = off + len;
+          } else if (rc != BLK_EBUSY) {
+            status = BLK_EIO;
+          }
+        }
+      }
+      if (m->active || (status == 0 && m->next < count)) {
+        pending = 1;
+      }
+    }
+    if (!pending) {
+      return status;
+    }
+  }
+}
+
+static int raid0_read(struct block_device *dev, uint32_t lba, void *buf,
+                      uint32_t count) {
+  return raid0_rw(dev, lba, buf, count, 0);
+}
+
+static int raid0_write(struct block_device *dev, uint32_t lba,
+                       const void *buf, uint32_t count) {
+  return raid0_rw(dev, lba, (uint8_t *)buf, count, 1);
+}
+
+static int raid0_flush(struct block_device *dev) {
+  struct raid0 *r = dev->priv;
+  int status = 0;
+  for (int i = 0; i < r->count; i++) {
+    if (blk_flush(r->members[i]) != 0) {
+      status = BLK_EIO;
+    }
+  }
+  return status;
+}
+
+static const struct block_ops raid0_ops = {
+    "raid0", raid0_read, raid0_write, raid0_flush, NULL, NULL,
+};
+
+struct block_device *raid0_create(struct block_device **members, int count,
+                                  uint32_t chunk) {
+  if (array_count == RAID0_MAX_ARRAYS || count < 2 ||
+      count > RAID0_MAX_MEMBERS || chunk == 0) {
+    return NULL;
+  }
+  uint32_t per_disk = members[0]->sectors;
+  for (int i = 0; i < count; i++) {
+    if (members[i]->sector_size != SECTOR_SIZE) {
+      return NULL;
+    }
+    for (int j = 0; j < i; j++) {
+      if (members[j] == members[i]) {
+        return NULL;
+      }
+    }
+    if (members[i]->sectors < per_disk) {
+      per_disk = members[i]->sectors;
+    }
+  }
+  per_disk -= per_disk % chunk;
+  if (per_disk == 0) {
+    return NULL;
+  }
+
+  struct raid0 *r = &arrays[array_count];
+  for (int i = 0; i < count; i++) {
+    r->members[i] = members[i];
+  }
+  r->count = count;
+  r->chunk = chunk;
+  r->dev.name[0] = 'm';
+  r->dev.name[1] = 'd';
+  r->dev.name[2] = '0' + array_count;
+  r->dev.name[3] = '\0';
+  r->dev.sectors = per_disk * count;
+  r->dev.sector_size = SECTOR_SIZE;
+  r->dev.ops = &raid0_ops;
+  r->dev.priv = r;
+  if (blk_register(&r->dev) != 0) {
+    return NULL;
+  }
+  array_count++;
+  return &r->dev;
+}
@@ -0,0 +1,17 @@
+#ifndef KERNEL_RAID0_H
+#define KERNEL_RAID0_H
+
+// RAID-0: чередование кусков по chunk секторов между дисками. Кусок k
+// лежит на диске k % count по смещению (k / count) * chunk. Запросы к
+// разным дискам выдаются одновременно и опрашиваются по кругу, так что
+// диски на разных каналах работают параллельно.
+
+#include "blkdev.h"
+
+#define RAID0_MAX_MEMBERS 4
+#define RAID0_MAX_ARRAYS 2
+
+struct block_device *raid0_create(struct block_device **members, int count,
+                                  uint32_t chunk);
+
+#endif
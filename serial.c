@@ -0,0 +1,66 @@
+#include "serial.h"
+#include "io.h"
+
+#define COM1 0x3F8
+#define UART_DATA 0
+#define UART_IER 1
+#define UART_FCR 2
+#define UART_LCR 3
+#define UART_MCR 4
+#define UART_LSR 5
+
+#define LCR_DLAB 0x80
+#define LCR_8N1 0x03
+#define LSR_THRE 0x20
+#define MCR_LOOPBACK 0x1E
+#define MCR_NORMAL 0x0F
+
+#define SERIAL_TIMEOUT 100000
+
+static int serial_state = 0; // 0 - не проверен, 1 - есть, -1 - нет
+
+static int serial_probe(void) {
+  port_outb(0x00, COM1 + UART_IER); // без прерываний
+  port_outb(LCR_DLAB, COM1 + UART_LCR);
+  port_outb(0x01, COM1 + UART_DATA); // делитель 1: 115200
+  port_outb(0x00, COM1 + UART_IER);
+  port_outb(LCR_8N1, COM1 + UART_LCR);
+  port_outb(0xC7, COM1 + UART_FCR); // FIFO 14 байт, сброс
+
+  // Петля: отправленный байт должен вернуться в регистр данных
+  port_outb(MCR_LOOPBACK, COM1 + UART_MCR);
+  port_outb(0xAE, COM1 + UART_DATA);
+  if (port_inb(COM1 + UART_DATA) != 0xAE) {
+    return -1;
+  }
+  port_outb(MCR_NORMAL, COM1 + UART_MCR);
+  return 1;
+}
+
+int serial_ready(void) {
+  if (serial_state == 0) {
+    serial_state = serial_probe();
+  }
+  return serial_state > 0;
+}
+
+void serial_putc(char c) {
+  if (!serial_ready()) {
+    return;
+  }
+  if (c == '\n') {
+    serial_putc('\r');
+  }
+  for (int timeout = SERIAL_TIMEOUT; timeout > 0; timeout--) {
+    if (port_inb(COM1 + UART_LSR) & LSR_THRE) {
+      break;
+    }
+  }
+  port_outb(c, COM1 + UART_DATA);
+}
+
+void serial_print(char *str) {
+  while (*str) {
+    serial_putc(*str++);
+  }
+}
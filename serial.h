@@ -0,0 +1,14 @@
+#ifndef KERNEL_SERIAL_H
+#define KERNEL_SERIAL_H
+
+// COM1 (16550, 115200 8N1) для запусков без экрана: qemu -serial stdio.
+// Порт проверяется не при загрузке, а при первой записи
+
+#include "types.h"
+
+// 1 - порт есть (первый вызов настраивает его и проверяет петлёй)
+int serial_ready(void);
+void serial_putc(char c);
+void serial_print(char *str);
+
+#endif
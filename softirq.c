@@ -0,0 +1,155 @@
+#include "softirq.h"
+#include "irq.h"
+#include "kernel.h"
+#include "tsc.h"
+
+struct work {
+  uint32_t type;
+  uint32_t arg;
+  uint64_t stamp;
+};
+
+// Кольцо без блокировок: пишет только код этого процессора с выключенными
+// прерываниями (head), читает только softirq_run (tail). Индексы растут
+// без ограничения, позиция в кольце - по маске
+struct softirq_cpu {
+  struct work ring[WORK_QUEUE_SIZE];
+  volatile uint32_t head;
+  volatile uint32_t tail;
+  volatile int active; // softirq_run уже выполняется (вложенный выход из IRQ)
+  uint32_t runs;
+  uint32_t budget_exhausted;
+};
+
+static struct softirq_cpu cpus[NR_CPUS];
+static work_fn_t work_handlers[WORK_TYPES];
+struct work_stats work_stats[WORK_TYPES];
+
+// Процессор один; с SMP номер брался бы из APIC ID
+static inline struct softirq_cpu *this_cpu(void) { return &cpus[0]; }
+
+#define barrier() __asm__ volatile("" : : : "memory")
+
+void softirq_register(int type, const char *name, work_fn_t fn) {
+  work_stats[type].name = name;
+  work_handlers[type] = fn;
+}
+
+int work_queue(int type, uint32_t arg) {
+  // Вызов не из IRQ мог бы прерваться обработчиком, который тоже пишет в
+  // очередь, поэтому локально выключаем прерывания
+  uint32_t flags = irq_save();
+  struct softirq_cpu *cpu = this_cpu();
+  int rc = 0;
+
+  if (cpu->head - cpu->tail == WORK_QUEUE_SIZE) {
+    work_stats[type].dropped++;
+    rc = -1;
+  } else {
+    struct work *w = &cpu->ring[cpu->head & (WORK_QUEUE_SIZE - 1)];
+    w->type = type;
+    w->arg = arg;
+    w->stamp = rdtsc();
+    barrier();
+    cpu->head++;
+    work_stats[type].queued++;
+  }
+  irq_restore(flags);
+  return rc;
+}
+
+int softirq_pending(void) {
+  struct softirq_cpu *cpu = this_cpu();
+  return cpu->head != cpu->tail && !cpu->active;
+}
+
+void softirq_run(void) {
+  struct softirq_cpu *cpu = this_cpu();
+  uint32_t budget = SOFTIRQ_BUDGET;
+
+  if (cpu->active) {
+    return;
+  }
+  cpu->active = 1;
+  cpu->runs++;
+  while (cpu->tail != cpu->head) {
+    if (budget-- == 0) {
+      cpu->budget_exhausted++; // остаток разберёт цикл ожидания
+      break;
+    }
+    struct work w = cpu->ring[cpu->tail & (WORK_QUEUE_SIZE - 1)];
+    barrier();
+    cpu->tail++;
+
+    struct work_stats *st = &work_stats[w.type];
+    uint64_t start = rdtsc();
+    if (start - w.stamp > st->max_latency) {
+      st->max_latency = start - w.stamp;
+    }
+    if (work_handlers[w.type]) {
+      work_handlers[w.type](w.arg);
+    }
+    uint64_t runtime = rdtsc() - start;
+    if (runtime > st->max_runtime) {
+      st->max_runtime = runtime;
+    }
+    st->executed++;
+  }
+  cpu->active = 0;
+}
+
+static void print_cycles(uint64_t cycles) {
+  print_uint(tsc_to_us(cycles));
+  print_string(" us (");
+  print_uint((uint32_t)cycles);
+  print_string(" cycles)");
+}
+
+void cmd_irqstat(int argc, char **argv) {
+  print_string("uptime ");
+  print_uint(uptime_ticks / TIMER_HZ);
+  print_string(" s\n");
+  for (int i = 0; i < IRQ_LINES; i++) {
+    if (irq_stats[i].count == 0 && irq_stats[i].spurious == 0) {
+      continue;
+    }
+    print_string("irq ");
+    print_uint(i);
+    print_string(": ");
+    print_uint(irq_stats[i].count);
+    if (irq_stats[i].spurious) {
+      print_string(" (+");
+      print_uint(irq_stats[i].spurious);
+      print_string(" spurious)");
+    }
+    print_string(", max in handler ");
+    print_cycles(irq_stats[i].max_cycles);
+    print_char('\n');
+  }
+  for (int i = 0; i < WORK_TYPES; i++) {
+    struct work_stats *st = &work_stats[i];
+    if (!st->name) {
+      continue;
+    }
+    print_string((char *)st->name);
+    print_string(": queued ");
+    print_uint(st->queued);
+    print_string(", executed ");
+    print_uint(st->executed);
+    if (st->dropped) {
+      print_string(", dropped ");
+      print_uint(st->dropped);
+    }
+    print_string("\n  max latency ");
+    print_cycles(st->max_latency);
+    print_string(", max run ");
+    print_cycles(st->max_runtime);
+    print_char('\n');
+  }
+  struct softirq_cpu *cpu = this_cpu();
+  print_string("softirq runs ");
+  print_uint(cpu->runs);
+  print_string(", budget exhausted ");
+  print_uint(cpu->budget_exhausted);
+  print_char('\n');
+}
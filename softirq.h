@@ -0,0 +1,45 @@
+#ifndef KERNEL_SOFTIRQ_H
+#define KERNEL_SOFTIRQ_H
+
+// Отложенная работа. Обработчики IRQ кладут короткие элементы (тип и
+// 32-битный аргумент) в очередь своего процессора; очередь разбирается на
+// выходе из прерывания (с включёнными прерываниями) или в цикле ожидания
+// шелла, если бюджета на выходе не хватило.
+
+#include "types.h"
+
+#define NR_CPUS 1
+#define WORK_QUEUE_SIZE 256 // степень двойки
+#define SOFTIRQ_BUDGET 64   // элементов за один выход из прерывания
+
+enum {
+  WORK_TIMER,
+  WORK_KEYBOARD,
+  WORK_DISK,
+  WORK_TYPES,
+};
+
+typedef void (*work_fn_t)(uint32_t arg);
+
+struct work_stats {
+  const char *name;
+  uint32_t queued;
+  uint32_t executed;
+  uint32_t dropped;     // очередь была полна
+  uint64_t max_latency; // тактов от постановки в очередь до запуска
+  uint64_t max_runtime;
+};
+
+extern struct work_stats work_stats[WORK_TYPES];
+
+void softirq_register(int type, const char *name, work_fn_t fn);
+
+// Из обработчика IRQ или из обычного кода; 0 - поставлено, -1 - нет места
+int work_queue(int type, uint32_t arg);
+
+int softirq_pending(void);
+void softirq_run(void);
+
+void cmd_irqstat(int argc, char **argv);
+
+#endif
@@ -0,0 +1,127 @@
+#include "stream.h"
+#include "kernel.h"
+
+#define STREAM_POOL 16
+
+static char buffer_pool[STREAM_POOL][STREAM_BUF_SIZE]
+    __attribute__((aligned(STREAM_BUF_SIZE)));
+static uint8_t buffer_used[STREAM_POOL];
+
+struct stream *shell_out = NULL;
+
+static char *buffer_get(void) {
+  for (int i = 0; i < STREAM_POOL; i++) {
+    if (!buffer_used[i]) {
+      buffer_used[i] = 1;
+      return buffer_pool[i];
+    }
+  }
+  return NULL;
+}
+
+static void buffer_put(char *data) {
+  buffer_used[(data - buffer_pool[0]) / STREAM_BUF_SIZE] = 0;
+}
+
+int stream_open(struct stream *s, void (*consume)(void *, char *, uint32_t),
+                void (*finish)(void *), void *ctx) {
+  memset(s, 0, sizeof(*s));
+  for (int i = 0; i < STREAM_RING; i++) {
+    s->ring[i].data = buffer_get();
+    if (!s->ring[i].data) {
+      while (i-- > 0) {
+        buffer_put(s->ring[i].data);
+      }
+      return -1;
+    }
+  }
+  s->consume = consume;
+  s->finish = finish;
+  s->ctx = ctx;
+  return 0;
+}
+
+// Заполненный буфер уходит потребителю, запись продолжается в следующий
+void stream_flush(struct stream *s) {
+  struct stream_buf *buf = &s->ring[s->head];
+  if (buf->len == 0) {
+    return;
+  }
+  s->consume(s->ctx, buf->data, buf->len);
+  buf->len = 0;
+  s->head = (s->head + 1) % STREAM_RING;
+}
+
+void stream_write(struct stream *s, const char *data, uint32_t len) {
+  s->bytes += len;
+  while (len > 0) {
+    struct stream_buf *buf = &s->ring[s->head];
+    uint32_t n = STREAM_BUF_SIZE - buf->len;
+    if (n > len) {
+      n = len;
+    }
+    mem_cpy(buf->data + buf->len, (void *)data, n);
+    buf->len += n;
+    data += n;
+    len -= n;
+    if (buf->len == STREAM_BUF_SIZE) {
+      stream_flush(s);
+    }
+  }
+}
+
+void stream_pass(struct stream *s, char *data, uint32_t len) {
+  if (len == 0) {
+    return;
+  }
+  stream_flush(s); // сохранить порядок с уже накопленными данными
+  s->bytes += len;
+  s->passed += len;
+  s->consume(s->ctx, data, len);
+}
+
+void stream_close(struct stream *s) {
+  stream_flush(s);
+  if (s->finish) {
+    s->finish(s->ctx);
+  }
+  for (int i = 0; i < STREAM_RING; i++) {
+    buffer_put(s->ring[i].data);
+  }
+}
+
+// Закрытие при ошибке: накопленные данные отбрасываются, finish не вызывается
+void stream_abort(struct stream *s) {
+  for (int i = 0; i < STREAM_RING; i++) {
+    buffer_put(s->ring[i].data);
+  }
+}
+
+void sh_write(char *data, uint32_t len) {
+  if (shell_out) {
+    if (len >= STREAM_PASS_MIN) {
+      stream_pass(shell_out, data, len);
+    } else {
+      stream_write(shell_out, data, len);
+    }
+    return;
+  }
+  for (uint32_t i = 0; i < len; i++) {
+    print_char(data[i]);
+  }
+}
+
+void sh_print(char *str) { sh_write(str, str_len(str)); }
+
+void sh_putc(char c) { sh_write(&c, 1); }
+
+void sh_print_uint(uint32_t value) {
+  char buf[11];
+  int i = 10;
+  buf[i] = '\0';
+  do {
+    buf[--i] = '0' + value % 10;
+    value /= 10;
+  } while (value);
+  sh_print(&buf[i]);
+}
@@ -0,0 +1,46 @@
+#ifndef KERNEL_STREAM_H
+#define KERNEL_STREAM_H
+
+// Потоки вывода команд. Мелкие записи собираются в кольцо буферов размером
+// в страницу; крупные куски (страницы page cache, строки входного буфера)
+// передаются потребителю по ссылке, без копирования. Потребитель вызывается
+// синхронно и не должен хранить указатель после возврата.
+
+#include "types.h"
+
+#define STREAM_BUF_SIZE 4096
+#define STREAM_RING 2
+#define STREAM_PASS_MIN 256 // с этой длины sh_write передаёт данные по ссылке
+
+struct stream_buf {
+  char *data;
+  uint32_t len;
+};
+
+struct stream {
+  struct stream_buf ring[STREAM_RING];
+  int head;
+  void (*consume)(void *ctx, char *data, uint32_t len);
+  void (*finish)(void *ctx);
+  void *ctx;
+  uint32_t bytes;
+  uint32_t passed; // байт, переданных по ссылке
+};
+
+// Куда пишут команды; NULL - прямо на экран
+extern struct stream *shell_out;
+
+int stream_open(struct stream *s, void (*consume)(void *, char *, uint32_t),
+                void (*finish)(void *), void *ctx);
+void stream_write(struct stream *s, const char *data, uint32_t len);
+void stream_pass(struct stream *s, char *data, uint32_t len);
+void stream_flush(struct stream *s);
+void stream_close(struct stream *s);
+void stream_abort(struct stream *s);
+
+void sh_write(char *data, uint32_t len);
+void sh_print(char *str);
+void sh_putc(char c);
+void sh_print_uint(uint32_t value);
+
+#endif
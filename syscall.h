@@ -0,0 +1,16 @@
+#ifndef KERNEL_SYSCALL_H
+#define KERNEL_SYSCALL_H
+
+// Номера системных вызовов. Общий для ядра (process.c) и user/ulib.c
+//
+// ABI: eax - номер, ebx/esi/edi - аргументы, результат в eax.
+// Вход через sysenter (ecx = esp, edx = адрес возврата) или int 0x80.
+
+#define SYS_EXIT 1
+#define SYS_READ 3
+#define SYS_WRITE 4
+#define SYS_OPEN 5
+#define SYS_CLOSE 6
+#define SYS_GETPID 20
+
+#endif
@@ -0,0 +1,739 @@
+// mkkeprfs - создание, наполнение и проверка образов диска KeprOS на хосте
+//
+//   mkkeprfs [-s size] [-i inodes] [-z] <image> [dir...]  format (and load)
+//   mkkeprfs -c <image>                              offline fsck
+//   mkkeprfs -d <image>                              dump superblock and files
+//
+// size is in bytes with optional K/M/G suffix. Files from the dirs are laid
+// out back to back in the data region, so every file is one contiguous
+// extent. When several dirs contain the same name, the first one wins.
+// With -z every file is compressed in FS_CHUNK_SIZE chunks (see fs.h) and
+// kept compressed if that saves at least one block.
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../fs.h"
+#include "../lz.h"
+
+#define COPY_CHUNK (1 << 20)
+
+struct layout {
+  uint32_t total_blocks;
+  uint32_t bitmap_blocks;
+  uint32_t summary_blocks;
+  uint32_t inode_blocks;
+  uint32_t inode_count;
+};
+
+struct input_file {
+  char name[DISK_FILENAME];
+  char path[4096];
+  uint64_t size;
+  size_t order; // порядок обнаружения: каталоги в порядке аргументов
+  uint8_t *packed; // сжатое содержимое с картой кусков или NULL
+  uint32_t packed_size;
+};
+
+static const char *prog = "mkkeprfs";
+
+static void die(const char *msg) {
+  fprintf(stderr, "%s: %s\n", prog, msg);
+  exit(2);
+}
+
+static uint32_t div_up(uint64_t a, uint64_t b) {
+  return (uint32_t)((a + b - 1) / b);
+}
+
+static uint64_t parse_size(const char *s) {
+  char *end;
+  uint64_t v = strtoull(s, &end, 0);
+  switch (*end) {
+  case 'G':
+  case 'g':
+    v <<= 10; /* fallthrough */
+  case 'M':
+  case 'm':
+    v <<= 10; /* fallthrough */
+  case 'K':
+  case 'k':
+    v <<= 10;
+    break;
+  case '\0':
+    break;
+  default:
+    die("bad size suffix (use K, M or G)");
+  }
+  return v;
+}
+
+static void bitmap_set_range(uint8_t *bitmap, uint32_t first, uint32_t count) {
+  uint32_t b = first;
+  uint32_t end = first + count;
+
+  while (b < end && (b & 7)) {
+    bitmap[b / 8] |= 1 << (b & 7);
+    b++;
+  }
+  if (end - b >= 8) {
+    memset(bitmap + b / 8, 0xFF, (end - b) / 8);
+    b += (end - b) & ~7u;
+  }
+  while (b < end) {
+    bitmap[b / 8] |= 1 << (b & 7);
+    b++;
+  }
+}
+
+static int bitmap_test(const uint8_t *bitmap, uint32_t block) {
+  return (bitmap[block / 8] >> (block & 7)) & 1;
+}
+
+static void compute_layout(struct layout *l, uint64_t total_blocks,
+                           uint32_t inodes) {
+  if (total_blocks > 0xFFFFFFFFull) {
+    die("image too large for 32-bit block numbers");
+  }
+  l->total_blocks = (uint32_t)total_blocks;
+  l->bitmap_blocks = div_up(total_blocks, BITS_PER_BITMAP_BLOCK);
+  l->summary_blocks = div_up(l->bitmap_blocks, GROUP_ENTRIES_PER_BLOCK);
+  l->inode_blocks = div_up(inodes, INODES_PER_BLOCK);
+  l->inode_count = l->inode_blocks * INODES_PER_BLOCK;
+}
+
+static uint32_t data_start(const struct layout *l) {
+  return 1 + l->bitmap_blocks + l->summary_blocks + l->inode_blocks;
+}
+
+// Свободные блоки каждой группы по битовой карте
+static uint32_t *group_summary(const uint8_t *bitmap, uint32_t total_blocks,
+                               uint32_t groups) {
+  uint32_t *free_count = calloc(
+      (size_t)div_up(groups, GROUP_ENTRIES_PER_BLOCK), BLOCK_SIZE);
+  for (uint32_t b = 0; b < total_blocks; b++) {
+    if (!bitmap_test(bitmap, b)) {
+      free_count[b / BLOCKS_PER_GROUP]++;
+    }
+  }
+  return free_count;
+}
+
+static int cmp_input(const void *a, const void *b) {
+  const struct input_file *fa = a, *fb = b;
+  int r = strcmp(fa->name, fb->name);
+  if (r == 0) {
+    return fa->order < fb->order ? -1 : fa->order > fb->order;
+  }
+  return r;
+}
+
+struct file_list {
+  struct input_file *files;
+  size_t count;
+  size_t cap;
+  uint64_t data_blocks;
+};
+
+// Регулярные файлы каталога dir (без рекурсии: ФС одноуровневая)
+static void scan_dir(const char *dir, struct file_list *list) {
+  DIR *d = opendir(dir);
+  if (!d) {
+    perror(dir);
+    exit(2);
+  }
+  struct dirent *de;
+
+  while ((de = readdir(d)) != NULL) {
+    struct stat st;
+    char path[4096];
+
+    snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+      continue;
+    }
+    if (strlen(de->d_name) >= DISK_FILENAME) {
+      fprintf(stderr, "%s: skipping %s: name longer than %d\n", prog,
+              de->d_name, DISK_FILENAME - 1);
+      continue;
+    }
+    if (st.st_size > 0xFFFFFFFFll) {
+      fprintf(stderr, "%s: skipping %s: larger than 4G\n", prog, de->d_name);
+      continue;
+    }
+    if (list->count == list->cap) {
+      list->cap = list->cap ? list->cap * 2 : 64;
+      list->files = realloc(list->files, list->cap * sizeof(*list->files));
+    }
+    struct input_file *f = &list->files[list->count++];
+    strcpy(f->name, de->d_name);
+    strcpy(f->path, path);
+    f->size = st.st_size;
+    f->order = list->count - 1;
+  }
+  closedir(d);
+}
+
+// Сортировка по имени (устойчивая к порядку readdir) и удаление дублей
+static void finish_list(struct file_list *list) {
+  size_t n = 0;
+
+  qsort(list->files, list->count, sizeof(*list->files), cmp_input);
+  list->data_blocks = 0;
+  for (size_t i = 0; i < list->count; i++) {
+    if (n > 0 && !strcmp(list->files[n - 1].name, list->files[i].name)) {
+      fprintf(stderr, "%s: skipping duplicate %s\n", prog,
+              list->files[i].path);
+      continue;
+    }
+    list->files[n++] = list->files[i];
+    list->data_blocks += div_up(list->files[i].size, BLOCK_SIZE);
+  }
+  list->count = n;
+}
+
+static uint8_t *load_file(const struct input_file *f) {
+  uint8_t *data = malloc(f->size ? f->size : 1);
+  int fd = open(f->path, O_RDONLY);
+  if (!data || fd < 0) {
+    perror(f->path);
+    exit(2);
+  }
+  uint64_t done = 0;
+  while (done < f->size) {
+    ssize_t n = read(fd, data + done, f->size - done);
+    if (n <= 0) {
+      perror(f->path);
+      exit(2);
+    }
+    done += n;
+  }
+  close(fd);
+  return data;
+}
+
+// Карта кусков и сжатые куски; кусок, который не сжимается, хранится как
+// есть (его длина равна несжатой). Результат остаётся, только если он
+// занимает меньше блоков, чем исходный файл
+static void pack_file(struct input_file *f) {
+  static uint16_t table[LZ_HASH_SIZE];
+  uint32_t chunks = fs_chunk_count(f->size);
+  uint32_t map = (chunks + 1) * sizeof(uint32_t);
+
+  if (f->size == 0) {
+    return;
+  }
+  uint8_t *data = load_file(f);
+  uint8_t *out = malloc(map + (size_t)chunks * FS_CHUNK_SIZE);
+  uint32_t *offsets = (uint32_t *)out;
+  uint64_t pos = map;
+
+  for (uint32_t i = 0; i < chunks; i++) {
+    uint64_t off = (uint64_t)i * FS_CHUNK_SIZE;
+    uint32_t len = f->size - off > FS_CHUNK_SIZE ? FS_CHUNK_SIZE
+                                                 : (uint32_t)(f->size - off);
+    offsets[i] = (uint32_t)pos;
+    uint32_t n = lz_compress(data + off, len, out + pos, len - 1, table);
+    if (n == 0) {
+      memcpy(out + pos, data + off, len);
+      n = len;
+    }
+    pos += n;
+  }
+  free(data);
+  if (pos > 0xFFFFFFFFull ||
+      div_up(pos, BLOCK_SIZE) >= div_up(f->size, BLOCK_SIZE)) {
+    free(out);
+    return;
+  }
+  offsets[chunks] = (uint32_t)pos;
+  f->packed = out;
+  f->packed_size = (uint32_t)pos;
+}
+
+static uint32_t stored_blocks(const struct input_file *f) {
+  return div_up(f->packed ? f->packed_size : f->size, BLOCK_SIZE);
+}
+
+static void copy_file(int out, const struct input_file *f, uint32_t block,
+                      char *chunk) {
+  int in = open(f->path, O_RDONLY);
+  if (in < 0) {
+    perror(f->path);
+    exit(2);
+  }
+  off_t pos = (off_t)block * BLOCK_SIZE;
+  ssize_t n;
+  while ((n = read(in, chunk, COPY_CHUNK)) > 0) {
+    if (pwrite(out, chunk, n, pos) != n) {
+      perror("pwrite");
+      exit(2);
+    }
+    pos += n;
+  }
+  if (n < 0) {
+    perror(f->path);
+    exit(2);
+  }
+  close(in);
+}
+
+static void write_all(int fd, const void *buf, size_t len, uint32_t block) {
+  if (pwrite(fd, buf, len, (off_t)block * BLOCK_SIZE) != (ssize_t)len) {
+    perror("pwrite");
+    exit(2);
+  }
+}
+
+static int do_format(const char *image, uint64_t size, uint32_t inodes,
+                     int compress, char **dirs, int ndirs) {
+  struct file_list list = {0};
+  struct layout l;
+
+  for (int i = 0; i < ndirs; i++) {
+    scan_dir(dirs[i], &list);
+  }
+  finish_list(&list);
+  struct input_file *files = list.files;
+  size_t nfiles = list.count;
+  uint64_t data_blocks = list.data_blocks;
+  if (compress) {
+    data_blocks = 0;
+    for (size_t i = 0; i < nfiles; i++) {
+      pack_file(&files[i]);
+      data_blocks += stored_blocks(&files[i]);
+    }
+  }
+  if (inodes == 0) {
+    uint64_t blocks = size ? size / BLOCK_SIZE : TOTAL_BLOCKS;
+    inodes = blocks / 32 > 64 ? (uint32_t)(blocks / 32) : 64;
+    if (inodes < nfiles) {
+      inodes = nfiles;
+    }
+  }
+  if (inodes < nfiles) {
+    die("more files than inodes (raise -i)");
+  }
+
+  if (size == 0) {
+    // Автоматический размер: данные + метаданные + 25% запаса
+    compute_layout(&l, TOTAL_BLOCKS, inodes);
+    uint64_t need = data_start(&l) + data_blocks;
+    if (need > TOTAL_BLOCKS) {
+      compute_layout(&l, need + need / 4, inodes);
+    }
+  } else {
+    compute_layout(&l, size / BLOCK_SIZE, inodes);
+  }
+  if ((uint64_t)data_start(&l) + data_blocks > l.total_blocks) {
+    fprintf(stderr, "%s: %llu data blocks do not fit into %u blocks\n", prog,
+            (unsigned long long)data_blocks, l.total_blocks);
+    return 2;
+  }
+
+  int fd = open(image, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    perror(image);
+    return 2;
+  }
+  if (ftruncate(fd, (off_t)l.total_blocks * BLOCK_SIZE) != 0) {
+    perror("ftruncate");
+    return 2;
+  }
+
+  uint8_t *bitmap = calloc(l.bitmap_blocks, BLOCK_SIZE);
+  struct DiskFileEntry *table = calloc(l.inode_blocks, BLOCK_SIZE);
+  char *chunk = malloc(COPY_CHUNK);
+  uint32_t next = data_start(&l);
+
+  bitmap_set_range(bitmap, 0, data_start(&l));
+  for (size_t i = 0; i < nfiles; i++) {
+    uint32_t blocks = stored_blocks(&files[i]);
+    struct DiskFileEntry *e = &table[i];
+
+    strcpy(e->name, files[i].name);
+    e->size = (uint32_t)files[i].size;
+    e->start_block = next;
+    e->blocks_count = blocks;
+    e->is_used = 1;
+    if (files[i].packed) {
+      e->flags = FS_FILE_COMPRESSED;
+      write_all(fd, files[i].packed, files[i].packed_size, next);
+      free(files[i].packed);
+    } else if (blocks) {
+      copy_file(fd, &files[i], next, chunk);
+    }
+    if (blocks) {
+      bitmap_set_range(bitmap, next, blocks);
+    }
+    next += blocks;
+  }
+
+  struct SuperBlock sb = {0};
+  uint8_t block[BLOCK_SIZE] = {0};
+
+  sb.magic = FS_MAGIC;
+  sb.total_blocks = l.total_blocks;
+  sb.free_blocks = l.total_blocks - next;
+  sb.bitmap_start = 1;
+  sb.summary_start = 1 + l.bitmap_blocks;
+  sb.group_count = l.bitmap_blocks;
+  sb.inode_start = sb.summary_start + l.summary_blocks;
+  sb.data_start = data_start(&l);
+  sb.inode_count = l.inode_count;
+  sb.free_inodes = l.inode_count - (uint32_t)nfiles;
+  sb.state = FS_STATE_CLEAN;
+  sb.features = FS_FEATURE_SORTED; // finish_list отсортировал файлы
+  memcpy(block, &sb, sizeof(sb));
+
+  uint32_t *summary = group_summary(bitmap, l.total_blocks, sb.group_count);
+  write_all(fd, block, BLOCK_SIZE, SUPERBLOCK_LBA);
+  write_all(fd, bitmap, (size_t)l.bitmap_blocks * BLOCK_SIZE, sb.bitmap_start);
+  write_all(fd, summary, (size_t)l.summary_blocks * BLOCK_SIZE,
+            sb.summary_start);
+  write_all(fd, table, (size_t)l.inode_blocks * BLOCK_SIZE, sb.inode_start);
+  if (close(fd) != 0) {
+    perror(image);
+    return 2;
+  }
+
+  printf("%s: %u blocks, %u inodes, data at %u, %zu files, %u blocks free\n",
+         image, sb.total_blocks, sb.inode_count, sb.data_start, nfiles,
+         sb.free_blocks);
+  free(files);
+  free(bitmap);
+  free(summary);
+  free(table);
+  free(chunk);
+  return 0;
+}
+
+struct image {
+  int fd;
+  struct SuperBlock sb;
+  uint8_t *bitmap;
+  uint32_t *summary; // NULL у образов без сводки групп
+  struct DiskFileEntry *table;
+  uint32_t bitmap_blocks;
+  uint32_t summary_blocks;
+};
+
+static int read_blocks(int fd, void *buf, uint32_t block, uint32_t count) {
+  size_t len = (size_t)count * BLOCK_SIZE;
+  return pread(fd, buf, len, (off_t)block * BLOCK_SIZE) == (ssize_t)len ? 0
+                                                                        : -1;
+}
+
+static int open_image(const char *path, struct image *img) {
+  uint8_t block[BLOCK_SIZE];
+
+  img->fd = open(path, O_RDONLY);
+  if (img->fd < 0) {
+    perror(path);
+    return -1;
+  }
+  if (read_blocks(img->fd, block, SUPERBLOCK_LBA, 1) != 0) {
+    fprintf(stderr, "%s: %s: short read\n", prog, path);
+    return -1;
+  }
+  memcpy(&img->sb, block, sizeof(img->sb));
+  if (img->sb.magic != FS_MAGIC) {
+    fprintf(stderr, "%s: %s: bad magic %08x\n", prog, path, img->sb.magic);
+    return -1;
+  }
+  const struct SuperBlock *sb = &img->sb;
+  uint32_t bitmap_end = sb->summary_start ? sb->summary_start : sb->inode_start;
+  if (!(sb->bitmap_start == 1 && sb->bitmap_start < bitmap_end &&
+        bitmap_end <= sb->inode_start &&
+        sb->inode_start < sb->data_start && sb->data_start <= sb->total_blocks &&
+        (uint64_t)sb->inode_start +
+                div_up(sb->inode_count, INODES_PER_BLOCK) <=
+            sb->data_start)) {
+    fprintf(stderr, "%s: %s: inconsistent layout in superblock\n", prog, path);
+    return -1;
+  }
+  img->bitmap_blocks = bitmap_end - sb->bitmap_start;
+  // Иначе fsck читал бы биты блоков за концом bitmap
+  if ((uint64_t)img->bitmap_blocks * BITS_PER_BITMAP_BLOCK <
+      sb->total_blocks) {
+    fprintf(stderr, "%s: %s: bitmap too small for %u blocks in superblock\n",
+            prog, path, sb->total_blocks);
+    return -1;
+  }
+  img->summary_blocks = sb->inode_start - bitmap_end;
+  img->bitmap = malloc((size_t)img->bitmap_blocks * BLOCK_SIZE);
+  img->summary = NULL;
+  if (sb->summary_start) {
+    if (sb->group_count != img->bitmap_blocks ||
+        img->summary_blocks !=
+            div_up(sb->group_count, GROUP_ENTRIES_PER_BLOCK)) {
+      fprintf(stderr, "%s: %s: bad group summary geometry\n", prog, path);
+      return -1;
+    }
+    img->summary = malloc((size_t)img->summary_blocks * BLOCK_SIZE);
+    if (read_blocks(img->fd, img->summary, sb->summary_start,
+                    img->summary_blocks) != 0) {
+      fprintf(stderr, "%s: %s: short read\n", prog, path);
+      return -1;
+    }
+  }
+  img->table = malloc((size_t)div_up(sb->inode_count, INODES_PER_BLOCK) *
+                      BLOCK_SIZE);
+  if (read_blocks(img->fd, img->bitmap, sb->bitmap_start,
+                  img->bitmap_blocks) != 0 ||
+      read_blocks(img->fd, img->table, sb->inode_start,
+                  div_up(sb->inode_count, INODES_PER_BLOCK)) != 0) {
+    fprintf(stderr, "%s: %s: short read\n", prog, path);
+    return -1;
+  }
+  return 0;
+}
+
+static int do_dump(const char *path) {
+  struct image img;
+  if (open_image(path, &img) != 0) {
+    return 2;
+  }
+  const struct SuperBlock *sb = &img.sb;
+  printf("magic        %08x\n", sb->magic);
+  printf("total_blocks %u\n", sb->total_blocks);
+  printf("free_blocks  %u\n", sb->free_blocks);
+  printf("bitmap_start %u (%u blocks)\n", sb->bitmap_start, img.bitmap_blocks);
+  printf("summary      %u (%u groups)\n", sb->summary_start, sb->group_count);
+  printf("inode_start  %u\n", sb->inode_start);
+  printf("data_start   %u\n", sb->data_start);
+  printf("inode_count  %u\n", sb->inode_count);
+  printf("free_inodes  %u\n", sb->free_inodes);
+  printf("state        %s\n", sb->state == FS_STATE_CLEAN ? "clean" : "dirty");
+  printf("features     %s\n", sb->features & FS_FEATURE_SORTED ? "sorted" : "-");
+  printf("\n%5s %-*s %10s %10s %8s %6s\n", "inode", DISK_FILENAME - 1,
+         "name", "size", "start", "blocks", "ratio");
+  for (uint32_t i = 0; i < sb->inode_count; i++) {
+    const struct DiskFileEntry *e = &img.table[i];
+    if (e->is_used) {
+      printf("%5u %-*.*s %10u %10u %8u", i, DISK_FILENAME - 1,
+             DISK_FILENAME - 1, e->name, e->size, e->start_block,
+             e->blocks_count);
+      if (e->flags & FS_FILE_COMPRESSED) {
+        printf(" %5.1fx",
+               (double)e->size / ((double)e->blocks_count * BLOCK_SIZE));
+      }
+      printf("\n");
+    }
+  }
+  return 0;
+}
+
+// Карта кусков сжатого файла и распаковка каждого куска
+static uint32_t check_packed(struct image *img, uint32_t i,
+                             const struct DiskFileEntry *e) {
+  uint32_t chunks = fs_chunk_count(e->size);
+  uint64_t extent = (uint64_t)e->blocks_count * BLOCK_SIZE;
+  uint64_t map = (uint64_t)(chunks + 1) * sizeof(uint32_t);
+  uint8_t out[FS_CHUNK_SIZE];
+
+  if (map > extent) {
+    printf("inode %u (%s): chunk map does not fit in %u blocks\n", i, e->name,
+           e->blocks_count);
+    return 1;
+  }
+  uint8_t *data = malloc(extent);
+  if (read_blocks(img->fd, data, e->start_block, e->blocks_count) != 0) {
+    printf("inode %u (%s): short read\n", i, e->name);
+    free(data);
+    return 1;
+  }
+  const uint32_t *offsets = (const uint32_t *)data;
+  for (uint32_t c = 0; c < chunks; c++) {
+    uint32_t len = e->size - c * FS_CHUNK_SIZE > FS_CHUNK_SIZE
+                       ? FS_CHUNK_SIZE
+                       : e->size - c * FS_CHUNK_SIZE;
+    uint32_t start = offsets[c], end = offsets[c + 1];
+    if (start < map || start >= end || end > extent || end - start > len ||
+        (end - start < len &&
+         lz_decompress(data + start, end - start, out, len) != (int)len)) {
+      printf("inode %u (%s): chunk %u is corrupt\n", i, e->name, c);
+      free(data);
+      return 1;
+    }
+  }
+  free(data);
+  return 0;
+}
+
+static int do_fsck(const char *path) {
+  struct image img;
+  if (open_image(path, &img) != 0) {
+    return 2;
+  }
+  const struct SuperBlock *sb = &img.sb;
+  uint8_t *seen = calloc(img.bitmap_blocks, BLOCK_SIZE);
+  uint32_t used_inodes = 0, errors = 0;
+
+  bitmap_set_range(seen, 0, sb->data_start);
+  for (uint32_t i = 0; i < sb->inode_count; i++) {
+    const struct DiskFileEntry *e = &img.table[i];
+    if (!e->is_used) {
+      continue;
+    }
+    used_inodes++;
+    if (memchr(e->name, '\0', DISK_FILENAME) == NULL || e->name[0] == '\0') {
+      printf("inode %u: bad name\n", i);
+      errors++;
+      continue;
+    }
+    if (e->flags & ~FS_FILE_COMPRESSED) {
+      printf("inode %u (%s): unknown flags %02x\n", i, e->name, e->flags);
+      errors++;
+    }
+    if (!(e->flags & FS_FILE_COMPRESSED) &&
+        e->blocks_count != div_up(e->size, BLOCK_SIZE)) {
+      printf("inode %u (%s): %u blocks for %u bytes\n", i, e->name,
+             e->blocks_count, e->size);
+      errors++;
+    }
+    if (e->blocks_count && (e->start_block < sb->data_start ||
+                            (uint64_t)e->start_block + e->blocks_count >
+                                sb->total_blocks)) {
+      printf("inode %u (%s): extent %u+%u outside data region\n", i, e->name,
+             e->start_block, e->blocks_count);
+      errors++;
+      continue;
+    }
+    if (e->flags & FS_FILE_COMPRESSED) {
+      errors += check_packed(&img, i, e);
+    }
+    for (uint32_t b = e->start_block; b < e->start_block + e->blocks_count;
+         b++) {
+      if (bitmap_test(seen, b)) {
+        printf("inode %u (%s): block %u is used twice\n", i, e->name, b);
+        errors++;
+        break;
+      }
+      seen[b / 8] |= 1 << (b & 7);
+    }
+    for (uint32_t j = 0; j < i; j++) {
+      if (img.table[j].is_used && !strncmp(img.table[j].name, e->name,
+                                           DISK_FILENAME)) {
+        printf("inode %u: duplicate name %s (inode %u)\n", i, e->name, j);
+        errors++;
+      }
+    }
+  }
+
+  if (sb->features & FS_FEATURE_SORTED) {
+    for (uint32_t i = 0; i < sb->inode_count; i++) {
+      const struct DiskFileEntry *e = &img.table[i];
+      if (i >= used_inodes ? e->is_used : !e->is_used) {
+        printf("inode %u: sorted table has a hole or a tail entry\n", i);
+        errors++;
+        break;
+      }
+      if (i > 0 && i < used_inodes &&
+          strncmp(img.table[i - 1].name, e->name, DISK_FILENAME) >= 0) {
+        printf("inode %u (%s): table is not sorted by name\n", i, e->name);
+        errors++;
+        break;
+      }
+    }
+  }
+
+  uint32_t used_blocks = 0, mismatched = 0;
+  for (uint32_t b = 0; b < sb->total_blocks; b++) {
+    int on_disk = bitmap_test(img.bitmap, b);
+    used_blocks += on_disk;
+    if (on_disk != bitmap_test(seen, b)) {
+      if (mismatched++ < 16) {
+        printf("block %u: bitmap says %s\n", b, on_disk ? "used" : "free");
+      }
+    }
+  }
+  if (mismatched) {
+    printf("%u blocks disagree with the bitmap\n", mismatched);
+    errors++;
+  }
+  if (sb->free_blocks != sb->total_blocks - used_blocks) {
+    printf("superblock free_blocks %u, bitmap has %u free\n", sb->free_blocks,
+           sb->total_blocks - used_blocks);
+    errors++;
+  }
+  if (img.summary) {
+    uint32_t *summary =
+        group_summary(img.bitmap, sb->total_blocks, sb->group_count);
+    for (uint32_t g = 0; g < sb->group_count; g++) {
+      if (summary[g] != img.summary[g]) {
+        printf("group %u: summary says %u free, bitmap has %u\n", g,
+               img.summary[g], summary[g]);
+        errors++;
+      }
+    }
+    free(summary);
+  }
+  if (sb->state != FS_STATE_CLEAN) {
+    printf("note: not cleanly unmounted, counters are rebuilt on mount\n");
+  }
+  if (sb->free_inodes != sb->inode_count - used_inodes) {
+    printf("superblock free_inodes %u, table has %u free\n", sb->free_inodes,
+           sb->inode_count - used_inodes);
+    errors++;
+  }
+
+  printf("%s: %u files, %u/%u blocks used, %s\n", path, used_inodes,
+         used_blocks, sb->total_blocks, errors ? "ERRORS FOUND" : "clean");
+  return errors ? 1 : 0;
+}
+
+static void usage(void) {
+  fprintf(stderr,
+          "usage: %s [-s size] [-i inodes] [-z] <image> [dir...]\n"
+          "       %s -c <image>\n"
+          "       %s -d <image>\n",
+          prog, prog, prog);
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  uint64_t size = 0;
+  uint32_t inodes = 0;
+  int opt, mode = 0, compress = 0;
+
+  while ((opt = getopt(argc, argv, "s:i:zcd")) != -1) {
+    switch (opt) {
+    case 's':
+      size = parse_size(optarg);
+      if (size / BLOCK_SIZE < 16) {
+        die("image is too small");
+      }
+      break;
+    case 'i':
+      inodes = (uint32_t)strtoul(optarg, NULL, 0);
+      break;
+    case 'z':
+      compress = 1;
+      break;
+    case 'c':
+    case 'd':
+      mode = opt;
+      break;
+    default:
+      usage();
+    }
+  }
+  if (optind >= argc) {
+    usage();
+  }
+  if (mode == 'c') {
+    return do_fsck(argv[optind]);
+  }
+  if (mode == 'd') {
+    return do_dump(argv[optind]);
+  }
+  return do_format(argv[optind], size, inodes, compress, argv + optind + 1,
+                   argc - optind - 1);
+}
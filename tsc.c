@@ -0,0 +1,55 @@
+#include "tsc.h"
+#include "io.h"
+#include "kernel.h"
+
+#define PIT_HZ 1193182
+#define PIT_CH2_PORT 0x42
+#define PIT_CMD_PORT 0x43
+#define PIT_GATE_PORT 0x61
+#define CALIBRATE_MS 10
+
+uint32_t tsc_khz = 0;
+
+// 64/32 деление без libgcc (__udivdi3 в -nostdlib недоступен)
+uint64_t udiv64(uint64_t n, uint32_t d) {
+  uint32_t hi = (uint32_t)(n >> 32);
+  uint32_t lo = (uint32_t)n;
+  uint32_t q_hi = hi / d;
+  uint32_t r = hi % d;
+  uint32_t q_lo;
+
+  __asm__("divl %4" : "=a"(q_lo), "=d"(r) : "a"(lo), "d"(r), "rm"(d));
+  return ((uint64_t)q_hi << 32) | q_lo;
+}
+
+void tsc_init(void) {
+  uint32_t latch = PIT_HZ / (1000 / CALIBRATE_MS);
+
+  // Канал 2 в режиме 0: OUT2 (бит 5 порта 0x61) поднимается через latch тиков
+  port_outb((port_inb(PIT_GATE_PORT) & ~0x02) | 0x01, PIT_GATE_PORT);
+  port_outb(0xB0, PIT_CMD_PORT);
+  port_outb(latch & 0xFF, PIT_CH2_PORT);
+  port_outb(latch >> 8, PIT_CH2_PORT);
+
+  uint64_t start = rdtsc();
+  while ((port_inb(PIT_GATE_PORT) & 0x20) == 0) {
+  }
+  uint64_t cycles = rdtsc() - start;
+
+  tsc_khz = (uint32_t)udiv64(cycles, CALIBRATE_MS);
+  if (tsc_khz < 1000) {
+    tsc_khz = 1000;
+  }
+}
+
+uint32_t tsc_to_us(uint64_t cycles) {
+  return (uint32_t)udiv64(cycles, tsc_khz / 1000);
+}
+
+void print_throughput(uint64_t bytes, uint32_t us) {
+  if (us == 0) {
+    us = 1;
+  }
+  print_uint((uint32_t)udiv64(bytes * 1000000 / 1024, us));
+  print_string(" KB/s");
+}
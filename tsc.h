@@ -0,0 +1,21 @@
+#ifndef KERNEL_TSC_H
+#define KERNEL_TSC_H
+
+// Измерение времени по счётчику тактов (TSC), калибровка по PIT
+
+#include "types.h"
+
+static inline uint64_t rdtsc(void) {
+  uint32_t lo, hi;
+  __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+  return ((uint64_t)hi << 32) | lo;
+}
+
+extern uint32_t tsc_khz;
+
+void tsc_init(void);
+uint64_t udiv64(uint64_t n, uint32_t d);
+uint32_t tsc_to_us(uint64_t cycles);
+void print_throughput(uint64_t bytes, uint32_t us);
+
+#endif
@@ -12,6 +12,9 @@ typedef unsigned int uint32_t;
 #ifdef __LP64__
 typedef signed long int64_t;
 typedef unsigned long uint64_t;
+#else
+typedef signed long long int64_t;
+typedef unsigned long long uint64_t;
 #endif
 
 typedef unsigned int size_t;
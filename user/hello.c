@@ -0,0 +1,31 @@
+#include "ulib.h"
+
+// hello [file] - печатает аргументы и, если задан, файл с диска
+int main(int argc, char **argv) {
+  char buf[512];
+  int n;
+
+  puts("Hello from ring 3, pid ");
+  put_uint(getpid());
+  puts(use_sysenter ? " (sysenter)\n" : " (int 0x80)\n");
+  for (int i = 0; i < argc; i++) {
+    puts("argv[");
+    put_uint(i);
+    puts("] = ");
+    puts(argv[i]);
+    puts("\n");
+  }
+  if (argc < 2) {
+    return 0;
+  }
+  int fd = open(argv[1]);
+  if (fd < 0) {
+    puts("cannot open file\n");
+    return 1;
+  }
+  while ((n = read(fd, buf, sizeof(buf))) > 0) {
+    write(1, buf, n);
+  }
+  close(fd);
+  return 0;
+}
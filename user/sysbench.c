@@ -0,0 +1,60 @@
+#include "../syscall.h"
+#include "ulib.h"
+
+// sysbench [iterations] - задержка пустого системного вызова (getpid)
+// через sysenter/sysexit и через int 0x80
+
+#define WARMUP 1000
+
+static uint32_t parse_uint(const char *s) {
+  uint32_t v = 0;
+  while (*s >= '0' && *s <= '9') {
+    v = v * 10 + (*s++ - '0');
+  }
+  return v;
+}
+
+static uint32_t bench(int (*call)(int, int, int, int), uint32_t iterations) {
+  for (int i = 0; i < WARMUP; i++) {
+    call(SYS_GETPID, 0, 0, 0);
+  }
+  uint64_t start = rdtsc();
+  for (uint32_t i = 0; i < iterations; i++) {
+    call(SYS_GETPID, 0, 0, 0);
+  }
+  uint64_t cycles = rdtsc() - start;
+  if (cycles >> 32) {
+    return 0xFFFFFFFF;
+  }
+  return (uint32_t)cycles / iterations;
+}
+
+static void report(const char *name, uint32_t cycles) {
+  puts(name);
+  put_uint(cycles);
+  puts(" cycles per round trip\n");
+}
+
+int main(int argc, char **argv) {
+  uint32_t iterations = argc > 1 ? parse_uint(argv[1]) : 10000;
+  if (iterations == 0) {
+    iterations = 1;
+  }
+
+  uint32_t int80 = bench(syscall_int80, iterations);
+  report("int 0x80:          ", int80);
+  if (!use_sysenter) {
+    puts("sysenter: not supported by this CPU\n");
+    return 0;
+  }
+  uint32_t fast = bench(syscall_sysenter, iterations);
+  report("sysenter/sysexit:  ", fast);
+  if (fast) {
+    puts("speedup x");
+    put_uint(int80 / fast);
+    puts(".");
+    put_uint((int80 * 10 / fast) % 10);
+    puts("\n");
+  }
+  return 0;
+}
@@ -0,0 +1,83 @@
+#include "ulib.h"
+#include "../syscall.h"
+
+#define CPUID_SEP (1 << 11)
+
+int use_sysenter = 0;
+
+// sysexit возвращает управление по edx со стеком из ecx
+int syscall_sysenter(int nr, int a1, int a2, int a3) {
+  int ret;
+  __asm__ volatile("movl %%esp, %%ecx\n"
+                   "movl $1f, %%edx\n"
+                   "sysenter\n"
+                   "1:\n"
+                   : "=a"(ret)
+                   : "a"(nr), "b"(a1), "S"(a2), "D"(a3)
+                   : "ecx", "edx", "memory");
+  return ret;
+}
+
+int syscall_int80(int nr, int a1, int a2, int a3) {
+  int ret;
+  __asm__ volatile("int $0x80"
+                   : "=a"(ret)
+                   : "a"(nr), "b"(a1), "S"(a2), "D"(a3)
+                   : "memory");
+  return ret;
+}
+
+int syscall(int nr, int a1, int a2, int a3) {
+  if (use_sysenter) {
+    return syscall_sysenter(nr, a1, a2, a3);
+  }
+  return syscall_int80(nr, a1, a2, a3);
+}
+
+void exit(int code) {
+  syscall(SYS_EXIT, code, 0, 0);
+  for (;;) {
+  }
+}
+
+int read(int fd, void *buf, uint32_t len) {
+  return syscall(SYS_READ, fd, (int)buf, len);
+}
+
+int write(int fd, const void *buf, uint32_t len) {
+  return syscall(SYS_WRITE, fd, (int)buf, len);
+}
+
+int open(const char *path) { return syscall(SYS_OPEN, (int)path, 0, 0); }
+
+int close(int fd) { return syscall(SYS_CLOSE, fd, 0, 0); }
+
+int getpid(void) { return syscall(SYS_GETPID, 0, 0, 0); }
+
+uint32_t strlen(const char *s) {
+  uint32_t n = 0;
+  while (s[n]) {
+    n++;
+  }
+  return n;
+}
+
+void puts(const char *s) { write(1, s, strlen(s)); }
+
+void put_uint(uint32_t value) {
+  char buf[11];
+  int i = 10;
+  buf[i] = '\0';
+  do {
+    buf[--i] = '0' + value % 10;
+    value /= 10;
+  } while (value);
+  puts(&buf[i]);
+}
+
+void _start(int argc, char **argv) {
+  uint32_t eax = 1, ebx, ecx, edx;
+  __asm__ volatile("cpuid" : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+  use_sysenter = (edx & CPUID_SEP) != 0;
+  exit(main(argc, argv));
+}
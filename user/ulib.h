@@ -0,0 +1,33 @@
+#ifndef USER_ULIB_H
+#define USER_ULIB_H
+
+// Минимальная библиотека для программ KeprOS (ring 3)
+
+#include "../types.h"
+
+extern int use_sysenter;
+
+int syscall_sysenter(int nr, int a1, int a2, int a3);
+int syscall_int80(int nr, int a1, int a2, int a3);
+int syscall(int nr, int a1, int a2, int a3);
+
+void exit(int code) __attribute__((noreturn));
+int read(int fd, void *buf, uint32_t len);
+int write(int fd, const void *buf, uint32_t len);
+int open(const char *path);
+int close(int fd);
+int getpid(void);
+
+uint32_t strlen(const char *s);
+void puts(const char *s);
+void put_uint(uint32_t value);
+
+static inline uint64_t rdtsc(void) {
+  uint32_t lo, hi;
+  __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+  return ((uint64_t)hi << 32) | lo;
+}
+
+int main(int argc, char **argv);
+
+#endif